@@ -1,47 +1,75 @@
-#-------------------------------------------------
-#
-# Project created by QtCreator 2016-05-29T02:30:38
-#
-#-------------------------------------------------
-
-QT       += core gui opengl
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-TARGET = TestShit
-TEMPLATE = app
-
-LIBS += -lglu32 -lopengl32
-
-SOURCES += main.cpp\
-        mainwindow.cpp \
-    data/doommap.cpp \
-    data/wadfile.cpp \
-    openmapdialog.cpp \
-    view2d.cpp \
-    glarray.cpp \
-    view3d.cpp \
-    data/texman.cpp \
-    resourcelistwidget.cpp \
-    resourceeditdialog.cpp
-
-HEADERS  += mainwindow.h \
-    data/doommap.h \
-    data/wadfile.h \
-    openmapdialog.h \
-    view2d.h \
-    glarray.h \
-    view3d.h \
-    data/texman.h \
-    resourcelistwidget.h \
-    resourceeditdialog.h
-
-FORMS    += mainwindow.ui \
-    openmapdialog.ui \
-    resourcelistwidget.ui \
-    resourceeditdialog.ui
-
-include(../QxPoly2Tri/QxPoly2Tri.pri)
-
-RESOURCES += \
-    resources.qrc
+#-------------------------------------------------
+#
+# Project created by QtCreator 2016-05-29T02:30:38
+#
+#-------------------------------------------------
+
+QT       += core gui opengl concurrent
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = TestShit
+TEMPLATE = app
+
+LIBS += -lglu32 -lopengl32
+
+# heap usage per load phase in the load report (glibc only)
+CONFIG(debug, debug|release): DEFINES += MAPLOADREPORT_HEAP
+
+SOURCES += main.cpp\
+        mainwindow.cpp \
+    data/doommap.cpp \
+    data/wadfile.cpp \
+    openmapdialog.cpp \
+    view2d.cpp \
+    glarray.cpp \
+    glmeshstore.cpp \
+    view3d.cpp \
+    data/texman.cpp \
+    resourcelistwidget.cpp \
+    resourceeditdialog.cpp \
+    data/doommapnodes.cpp \
+    data/nodebuilder.cpp \
+    data/maploadreport.cpp \
+    data/doommaptopology.cpp \
+    data/triangulator.cpp \
+    data/doommapintersections.cpp \
+    data/doommapproperties.cpp \
+    data/doommaparena.cpp \
+    data/doommapjournal.cpp \
+    data/doommaptextureindex.cpp \
+    data/doommaptagindex.cpp \
+    data/doommapgrid.cpp
+
+HEADERS  += mainwindow.h \
+    data/doommap.h \
+    data/wadfile.h \
+    openmapdialog.h \
+    view2d.h \
+    glarray.h \
+    glmeshstore.h \
+    view3d.h \
+    data/texman.h \
+    resourcelistwidget.h \
+    resourceeditdialog.h \
+    data/doommapnodes.h \
+    data/nodebuilder.h \
+    data/maploadreport.h \
+    data/doommaptopology.h \
+    data/triangulator.h \
+    data/doommapintersections.h \
+    data/geometry.h \
+    data/doommapproperties.h \
+    data/doommaparena.h \
+    data/doommapjournal.h \
+    data/doommaptextureindex.h \
+    data/doommaptagindex.h \
+    data/doommapgrid.h
+
+FORMS    += mainwindow.ui \
+    openmapdialog.ui \
+    resourcelistwidget.ui \
+    resourceeditdialog.ui
+
+RESOURCES += \
+    resources.qrc
@@ -1,709 +1,2112 @@
-#include "doommap.h"
-#include <QBuffer>
-#include <QDataStream>
-#include <QVector>
-#include <QPolygonF>
-#include <QPointF>
-#include <QLineF>
-#include <QxPoly2Tri>
-
-DoomMap::DoomMap()
-{
-
-}
-
-DoomMap::DoomMap(WADFile *wad, QString name)
-{
-    // find the last name.
-    int snum = wad->getSize();
-    while (true)
-    {
-        int num = wad->getLastNumForName(name, snum);
-        snum = num-1;
-
-        WADEntry* nextent = wad->getEntry(num+1);
-        if (!nextent)
-            continue;
-
-        if (nextent->getName().toUpper() == "THINGS") // classic map
-        {
-            bool validmap = true;
-            QStringList entriesOrder = QStringList() << "THINGS" << "LINEDEFS" << "SIDEDEFS" << "VERTEXES" << "SEGS" << "SSECTORS" << "NODES" << "SECTORS" << "REJECT" << "BLOCKMAP";
-            WADEntry* entries[10] = {0};
-            entries[0] = nextent;
-            for (int i = 1; i < entriesOrder.size(); i++)
-            {
-                WADEntry* ent = wad->getEntry(num+1+i);
-                if (!ent)
-                {
-                    validmap = false;
-                    break;
-                }
-
-                entries[i] = ent;
-            }
-
-            if (!validmap)
-                continue;
-
-            //
-            // check the presence of BEHAVIOR
-            //hasbehavior = wad->getEntry(num+entriesOrder.size()) && (wad->getEntry(num+entriesOrder.size())->getName().toUpper() == "BEHAVIOR");
-            WADEntry* behent = wad->getEntry(num+entriesOrder.size()+1);
-            if (behent && behent->getName().toUpper() == "BEHAVIOR") // hexen map
-            {
-                behavior = behent->getData();
-                WADEntry* scriptsent = wad->getEntry(num+entriesOrder.size()+2);
-                if (scriptsent && scriptsent->getName().toUpper() == "SCRIPTS")
-                    scripts = QString::fromUtf8(scriptsent->getData());
-                type = Hexen;
-            }
-            else type = Doom;
-
-            // load the map.
-            QBuffer _things(&entries[0]->getData());
-            QBuffer _linedefs(&entries[1]->getData());
-            QBuffer _sidedefs(&entries[2]->getData());
-            QBuffer _vertexes(&entries[3]->getData());
-            QBuffer _sectors(&entries[7]->getData());
-            _things.open(QIODevice::ReadOnly);
-            _linedefs.open(QIODevice::ReadOnly);
-            _sidedefs.open(QIODevice::ReadOnly);
-            _vertexes.open(QIODevice::ReadOnly);
-            _sectors.open(QIODevice::ReadOnly);
-
-            initClassic(&_things, &_linedefs, &_sidedefs, &_vertexes, &_sectors);
-            break;
-        }
-        else if (nextent->getName().toUpper() == "TEXTMAP") // textmap
-        {
-            int endnum = wad->getNumForName("ENDMAP", num+1);
-            if (endnum < 0)
-                continue; // invalid map
-            int behnum = wad->getNumForName("BEHAVIOR", num+1);
-            int scriptsnum = wad->getNumForName("SCRIPTS", num+1);
-            if (behnum >= 0 && behnum < endnum)
-                behavior = wad->getEntry(behnum)->getData();
-            if (scriptsnum >= 0 && scriptsnum < endnum)
-                scripts = QString::fromUtf8(wad->getEntry(scriptsnum)->getData());
-            type = UDMF;
-
-            // load the map
-            initUDMF(QString::fromUtf8(nextent->getData()));
-            break;
-        }
-        else continue;
-    }
-
-    // triangulate sectors
-    for (int i = 0; i < sectors.size(); i++)
-        sectors[i].triangulate();
-}
-
-static int DetectMapsSorter(const void* a, const void* b)
-{
-    DetectedDoomMap* ma = (DetectedDoomMap*)a;
-    DetectedDoomMap* mb = (DetectedDoomMap*)b;
-    return ma->name.compare(mb->name);
-}
-
-QVector<DetectedDoomMap> DoomMap::detectMaps(WADFile* wad)
-{
-    QVector<DetectedDoomMap> maps;
-
-    int snum = 0;
-    while (true)
-    {
-        // find next THINGS lump or TEXTMAP lump.
-        int tnum = wad->getNumForName("THINGS", snum);
-        int unum = wad->getNumForName("TEXTMAP", snum);
-        int num = -1;
-        if (tnum < 0)
-            num = unum;
-        else if (unum < 0)
-            num = tnum;
-        else num = std::min(tnum, unum);
-
-        if (num < 0) // end of maps
-            break;
-
-        snum = num+1;
-
-        // check correct order of lumps if this is a text map
-        bool hasbehavior = false;
-        MapType type;
-        if (num == unum)
-        {
-            type = UDMF;
-            int endmap = wad->getNumForName("ENDMAP", snum);
-            if (endmap < 0)
-                continue; // invalid textmap
-            int behnum = wad->getNumForName("BEHAVIOR");
-            hasbehavior = behnum >= 0 && behnum < endmap;
-        }
-        else
-        {
-            bool validmap = true;
-            QStringList entriesOrder = QStringList() << "THINGS" << "LINEDEFS" << "SIDEDEFS" << "VERTEXES" << "SEGS" << "SSECTORS" << "NODES" << "SECTORS" << "REJECT" << "BLOCKMAP";
-            for (int i = 1; i < entriesOrder.size(); i++)
-            {
-                WADEntry* nextent = wad->getEntry(num+i);
-                if (nextent == 0 || (nextent->getName().toUpper() != entriesOrder[i]))
-                {
-                    validmap = false;
-                    break;
-                }
-            }
-
-            if (!validmap)
-                continue;
-
-            hasbehavior = wad->getEntry(num+entriesOrder.size()) && (wad->getEntry(num+entriesOrder.size())->getName().toUpper() == "BEHAVIOR");
-            if (hasbehavior)
-                type = Hexen;
-            else
-            {
-                // detect strife. or not.
-                type = Doom;
-            }
-        }
-
-        WADEntry* prevent = wad->getEntry(num-1);
-        if (prevent == 0)
-            continue; // :(
-
-        DetectedDoomMap ddm;
-        ddm.name = prevent->getName().toUpper();
-        ddm.type = type;
-        maps.append(ddm);
-    }
-
-    // sort maps by name
-    qsort(maps.data(), maps.size(), sizeof(DetectedDoomMap), &DetectMapsSorter);
-
-    return maps;
-}
-
-void DoomMap::initUDMF(QString text)
-{
-
-}
-
-void DoomMap::initClassic(QIODevice* things, QIODevice* linedefs, QIODevice* sidedefs, QIODevice* vertexes, QIODevice* sectors)
-{
-    // linedefs, sidedefs, sectors
-    // one vertex = 4 bytes
-    int numvertexes = vertexes->size() / 4;
-    QDataStream vertexes_stream(vertexes);
-    vertexes_stream.setByteOrder(QDataStream::LittleEndian);
-    for (int i = 0; i < numvertexes; i++)
-    {
-        qint16 x;
-        qint16 y;
-        vertexes_stream >> x >> y;
-        DoomMapVertex vx(this);
-        vx.x = (float)x;
-        vx.y = (float)y;
-        vertices.append(vx);
-    }
-
-    // one linedef = 14 bytes for Doom, and 16 bytes for Hexen
-    int numlinedefs = (type == Hexen) ? linedefs->size() / 16 : linedefs->size() / 14;
-    QDataStream linedefs_stream(linedefs);
-    linedefs_stream.setByteOrder(QDataStream::LittleEndian);
-    for (int i = 0; i < numlinedefs; i++)
-    {
-        if (type == Hexen)
-        {
-            quint16 v1;
-            quint16 v2;
-            quint16 flags;
-            quint8 special;
-            quint8 arg0;
-            quint8 arg1;
-            quint8 arg2;
-            quint8 arg3;
-            quint8 arg4;
-            quint16 sidefront;
-            quint16 sideback;
-            linedefs_stream >> v1 >> v2 >> flags >> special >> arg0 >> arg1 >> arg2 >> arg3 >> arg4 >> sidefront >> sideback;
-            DoomMapLinedef ln(this);
-            ln.v1 = (int)v1;
-            ln.v2 = (int)v2;
-            ln.special = (int)special;
-            ln.arg0 = (int)arg0;
-            ln.arg1 = (int)arg1;
-            ln.arg2 = (int)arg2;
-            ln.arg3 = (int)arg3;
-            ln.arg4 = (int)arg4;
-            ln.sidefront = (sidefront < 0xFFFF) ? (int)sidefront : -1;
-            ln.sideback = (sideback < 0xFFFF) ? (int)sideback : -1;
-            // todo parse flags
-            this->linedefs.append(ln);
-        }
-        else
-        {
-            quint16 v1;
-            quint16 v2;
-            quint16 flags;
-            quint16 special;
-            quint16 tag;
-            quint16 sidefront;
-            quint16 sideback;
-            linedefs_stream >> v1 >> v2 >> flags >> special >> tag >> sidefront >> sideback;
-            DoomMapLinedef ln(this);
-            ln.v1 = (int)v1;
-            ln.v2 = (int)v2;
-            ln.special = (int)special;
-            ln.id = (int)tag;
-            ln.sidefront = (sidefront < 0xFFFF) ? (int)sidefront : -1;
-            ln.sideback = (sideback < 0xFFFF) ? (int)sideback : -1;
-            if ((flags & 0x0001) == 0x0001)
-                ln.blocking = true;
-            if ((flags & 0x0002) == 0x0002)
-                ln.blockmonsters = true;
-            if ((flags & 0x0004) == 0x0004)
-                ln.twosided = true;
-            if ((flags & 0x0008) == 0x0008)
-                ln.dontpegtop = true;
-            if ((flags & 0x0010) == 0x0010)
-                ln.dontpegbottom = true;
-            if ((flags & 0x0020) == 0x0020)
-                ln.secret = true;
-            if ((flags & 0x0040) == 0x0040)
-                ln.blocksound = true;
-            if ((flags & 0x0080) == 0x0080)
-                ln.dontdraw = true;
-            if ((flags & 0x0100) == 0x0100)
-                ln.mapped = true;
-            // todo parse zdoom/boom/strife flags
-            this->linedefs.append(ln);
-        }
-    }
-
-    // one sidedef = 30 bytes
-    int numsidedefs = sidedefs->size() / 30;
-    QDataStream sidedefs_stream(sidedefs);
-    sidedefs_stream.setByteOrder(QDataStream::LittleEndian);
-    for (int i = 0; i < numsidedefs; i++)
-    {
-        qint16 offsetx;
-        qint16 offsety;
-        char rtexturetop[9] = {0};
-        char rtexturebottom[9] = {0};
-        char rtexturemiddle[9] = {0};
-        quint16 sector;
-        sidedefs_stream >> offsetx >> offsety;
-        sidedefs_stream.readRawData(rtexturetop, 8);
-        sidedefs_stream.readRawData(rtexturebottom, 8);
-        sidedefs_stream.readRawData(rtexturemiddle, 8);
-        sidedefs_stream >> sector;
-        DoomMapSidedef sd(this);
-        sd.offsetx = (float)offsetx;
-        sd.offsety = (float)offsety;
-        sd.texturetop = QString::fromUtf8(rtexturetop);
-        sd.texturebottom = QString::fromUtf8(rtexturebottom);
-        sd.texturemiddle = QString::fromUtf8(rtexturemiddle);
-        sd.sector = (int)sector;
-        this->sidedefs.append(sd);
-    }
-
-    // one sector = 26 bytes
-    int numsectors = sectors->size() / 26;
-    QDataStream sectors_stream(sectors);
-    sectors_stream.setByteOrder(QDataStream::LittleEndian);
-    for (int i = 0; i < numsectors; i++)
-    {
-        qint16 heightfloor;
-        qint16 heightceiling;
-        char texturefloor[9] = {0};
-        char textureceiling[9] = {0};
-        qint16 lightlevel;
-        quint16 special;
-        quint16 tag;
-        sectors_stream >> heightfloor >> heightceiling;
-        sectors_stream.readRawData(texturefloor, 8);
-        sectors_stream.readRawData(textureceiling, 8);
-        sectors_stream >> lightlevel >> special >> tag;
-        DoomMapSector sec(this);
-        sec.heightfloor = (float)heightfloor;
-        sec.heightceiling = (float)heightceiling;
-        sec.texturefloor = QString::fromUtf8(texturefloor);
-        sec.textureceiling = QString::fromUtf8(textureceiling);
-        sec.lightlevel = (int)lightlevel;
-        sec.special = (int)special;
-        sec.id = (int)tag;
-        this->sectors.append(sec);
-    }
-
-    // unpack sidedefs, also remove invalid sidedefs.
-    for (int i = 0; i < this->linedefs.size(); i++)
-    {
-        if (this->linedefs[i].sidefront >= this->sidedefs.size())
-            this->linedefs[i].sidefront = -1;
-        if (this->linedefs[i].sideback >= this->sidedefs.size())
-            this->linedefs[i].sideback = -1;
-    }
-
-    for (int i = 0; i < this->linedefs.size(); i++)
-    {
-        int vfront = this->linedefs[i].sidefront;
-        int vback = this->linedefs[i].sideback;
-
-        for (int j = 0; j < this->linedefs.size(); j++)
-        {
-            if (i == j)
-                continue;
-
-            int cfront = this->linedefs[j].sidefront;
-            int cback = this->linedefs[j].sideback;
-
-            if (cfront >= 0 && (cfront == vfront || cfront == vback))
-            {
-                DoomMapSidedef side = this->sidedefs[cfront];
-                this->sidedefs.append(side);
-                this->linedefs[j].sidefront = this->sidedefs.size()-1;
-            }
-
-            if (cback >= 0 && (cback == vfront || cback == vback))
-            {
-                DoomMapSidedef side = this->sidedefs[cback];
-                this->sidedefs.append(side);
-                this->linedefs[j].sideback = this->sidedefs.size()-1;
-            }
-        }
-    }
-}
-
-static float DoomMapSectorArea(QPolygonF& p)
-{
-    float at = 0;
-    for (int i = 0; i < p.size(); i++)
-    {
-        QPointF& p1 = p[i];
-        QPointF& p2 = p[(i+1)%p.size()];
-        float ac = (p1.x()*p2.y()) - (p2.x()*p1.y());
-        at += ac;
-    }
-
-    at /= 2;
-    if (at < 0) at = -at;
-    return at;
-}
-
-static int DoomMapSectorAreaSort(const void* a, const void* b)
-{
-    QPolygonF* pa = (QPolygonF*)a;
-    QPolygonF* pb = (QPolygonF*)b;
-    float aa = DoomMapSectorArea(*pa);
-    float ab = DoomMapSectorArea(*pb);
-
-    if (aa < ab) return 1;
-    if (aa > ab) return -1;
-    return 0;
-}
-
-QPair< QPolygonF, QVector<DoomMapLinedef*> > SectorPolygonTracer::nextPolygon(DoomMapLinedef* line)
-{
-    //
-    DoomMap* p = line->getParent();
-
-    int numsector = sector-p->sectors.data();
-
-    DoomMapVertex* vs = line->getV1(sector); // this is the vertex that we start from
-    DoomMapVertex* vp = 0; // this is the next vertex to find
-
-    QVector< QPair< QPolygonF, QVector<DoomMapLinedef*> > > results;
-
-    bool log = false;//(numsector == 0);
-
-    // scan twice, first with choosing larger angle, second with choosing smaller angle.
-    for (int k = 0; k < 2; k++)
-    {
-        if (log) qDebug("sector %d, pass %d", numsector, k);
-        if (log) qDebug("sector %d, line = %d", numsector, line-p->linedefs.data());
-
-        vp = line->getV2(sector);
-
-        QPolygonF poly;
-        QVector<DoomMapLinedef*> polylines;
-
-        poly.append(QPointF(vs->x, vs->y));
-        polylines.append(line);
-
-        DoomMapLinedef* prevld = line;
-
-        bool dbrk = false;
-        while (!dbrk)
-        {
-            DoomMapVertex* oldvp = vp;
-            for (int i = 0; i < linedefs.size(); i++)
-            {
-                DoomMapLinedef* linedef = linedefs[i];
-                DoomMapVertex* v1 = linedef->getV1(sector);
-                DoomMapVertex* v2 = linedef->getV2(sector);
-
-                // if this vertex is equal to vp, this is a next line in the current shape
-                if (vp)
-                {
-                    if (vp == v1 ||
-                        (vp->x == v1->x &&
-                         vp->y == v1->y))
-                    {
-                        // check if this is the first line.
-                        if ((vs == v1 ||
-                            (vs->x == v1->x &&
-                             vs->y == v1->y)))
-                        {
-                            //return QPair< QPolygonF, QVector<DoomMapLinedef*> > (QPolygonF(), QVector<DoomMapLinedef*>());
-                            // successful trace, add polygon
-                            dbrk = true;
-                            if (log) qDebug("sector %d, pass closed", numsector);
-                            break;
-                        }
-
-                        // otherwise make sure this linedef wasn't checked already.
-                        if (checkedlinedefs.contains(linedefs[i]) || polylines.contains(linedefs[i]))
-                            continue;
-
-                        // here we have multiple possible outcomes. to reduce recursive calls, check if there are multiple lines that start with this vertex and only recurse if there are.
-                        QVector<DoomMapLinedef*> outcomes;
-                        outcomes.append(linedef);
-
-                        for (int j = 0; j < linedefs.size(); j++)
-                        {
-                            if (checkedlinedefs.contains(linedefs[j]) || polylines.contains(linedefs[j]))
-                                continue;
-
-                            if (j == i)
-                                continue;
-
-                            DoomMapVertex* ov1 = linedefs[j]->getV1(sector);
-                            if (vp == ov1 ||
-                                (vp->x == ov1->x &&
-                                 vp->y == ov1->y))
-                            {
-                                outcomes.append(linedefs[j]);
-                            }
-                        }
-
-                        if (outcomes.size() == 1)
-                        {
-                            vp = v2;
-                            poly.append(QPointF(v1->x, v1->y));
-                            polylines.append(linedef);
-                            prevld = linedef;
-                            if (log) qDebug("sector %d, line = %d", numsector, linedef-p->linedefs.data());
-                        }
-                        else
-                        {
-                            DoomMapLinedef* refLinedef;
-                            float refAngle;
-                            if (k == 0) refAngle = 360;
-                            else if (k == 1) refAngle = -1;
-
-                            DoomMapVertex* pv1 = prevld->getV1(sector);
-                            DoomMapVertex* pv2 = prevld->getV2(sector);
-
-                            for (int j = 0; j < outcomes.size(); j++)
-                            {
-                                DoomMapLinedef* cLinedef = outcomes[j];
-                                DoomMapVertex* cV2 = cLinedef->getV2(sector);
-                                //float cAngle = QLineF(QPointF(pv1->x, pv1->y), QPointF(pv2->x, pv2->y)).angleTo(QLineF(QPointF(v1->x, v1->y), QPointF(cV2->x, cV2->y)));
-                                //float cAngle = QLineF(QPointF(v1->x, v1->y), QPointF(pv1->x, pv1->y)).angleTo(QLineF(QPointF(v1->x, v1->y), QPointF(cV2->x, cV2->y)));
-                                float cAngle = QLineF(v1->x, v1->y, cV2->x, cV2->y).angleTo(QLineF(v1->x, v1->y, pv1->x, pv1->y));
-                                if (log) qDebug("sector %d, possible line = %d, angle %f", numsector, cLinedef-p->linedefs.data(), cAngle);
-                                if ((k == 0 && cAngle < refAngle) ||
-                                    (k == 1 && cAngle > refAngle))
-                                {
-                                    vp = cV2;
-                                    refLinedef = cLinedef;
-                                    refAngle = cAngle;
-                                }
-                            }
-
-                            poly.append(QPointF(v1->x, v1->y));
-                            polylines.append(refLinedef);
-                            prevld = refLinedef;
-                            if (log) qDebug("sector %d, line = %d", numsector, refLinedef-p->linedefs.data());
-                        }
-                    }
-                }
-            }
-
-            if (oldvp == vp && !dbrk)
-            {
-                // no next vertex found. invalid polygon.
-                poly.clear();
-                polylines.clear();
-                dbrk = true;
-                if (log) qDebug("sector %d, pass NOT closed", numsector);
-                break;
-            }
-        }
-
-        if (poly.size())
-            results.append(QPair< QPolygonF, QVector<DoomMapLinedef*> > (poly, polylines));
-    }
-
-    // if there are no results, this empty pair is returned. it's okay and expected.
-    double refArea = 4294967296;
-    QPair< QPolygonF, QVector<DoomMapLinedef*> > refResult;
-    for (int i = 0; i < results.size(); i++)
-    {
-        double cArea = DoomMapSectorArea(results[i].first);
-        if (cArea < refArea)
-        {
-            refResult = results[i];
-            refArea = cArea;
-        }
-    }
-
-    if (log) qDebug("sector %d, result has %d vertices", numsector, refResult.first.size());
-
-    return refResult;
-}
-
-void DoomMapSector::triangulate()
-{
-    vertices.clear();
-    triangles.vertices.clear();
-    // first, split the sector into line loops (polygons)
-    SectorPolygonTracer spt(this);
-
-    // go through linedefs in clockwise order and split the sector into separate shapes.
-    QVector<QPolygonF> polygons = spt.getPolygons();
-
-    if (polygons.size() < 1)
-        return;
-
-    qsort(polygons.data(), polygons.size(), sizeof(QPolygonF), &DoomMapSectorAreaSort);
-
-    for (int i = 0; i < polygons.size(); i++)
-    {
-        QPolygonF& poly = polygons[i];
-        for (int k = 0; k < poly.size(); k++)
-        {
-            QPointF prevpt = (k == 0) ? (poly[poly.size()-1]) : poly[k-1];
-            QPointF nextpt = poly[(k+1)%poly.size()];
-
-            if (!QLineF(prevpt, poly[k]).angleTo(QLineF(poly[k], nextpt)))
-            {
-                // delete this vertex
-                poly.removeAt(k);
-                k--;
-            }
-        }
-    }
-
-    for (int i = 0; i < polygons.size(); i++)
-    {
-        QPolygonF& poly = polygons[i];
-        // remove too small poly
-        if (poly.size() < 3)
-        {
-            polygons.removeAt(i);
-            i--;
-        }
-
-        ///////// GROSS HACK
-        /// this is made to circumvent the "no vertices should occupy the same position" rule. if this is not present, poly2tri will randomly crash.
-        float offs = (float)0.000001;
-        for (int k = 0; k < poly.size(); k++)
-        {
-            // nested gross hack
-            QPointF prevpt = (k == 0) ? (poly[poly.size()-1]) : poly[k-1];
-            QPointF nextpt = poly[(k+1)%poly.size()];
-
-            QLineF vec1 = QLineF(poly[k], prevpt).unitVector();
-            QLineF vec2 = QLineF(poly[k], nextpt).unitVector();
-            QLineF midline(0, 0, (vec1.dx()+vec2.dx())/2, (vec1.dy()+vec2.dy())/2);
-
-            poly[k].setX(poly[k].x()+midline.dx()*offs);
-            poly[k].setY(poly[k].y()+midline.dy()*offs);
-        }
-        ///////// END GROSS HACK
-    }
-
-    // for each polygon, check intersections and add holes.
-    for (int i = 0; i < polygons.size(); i++)
-    {
-        QPolygonF& poly = polygons[i];
-
-        QList<QPolygonF> holes;
-        for (int j = 0; j < polygons.size(); j++) // note: self-intersecting polygons will be handled very very bad here
-        {
-            if (i == j) continue;
-
-            // check intersection
-            if (poly.intersected(polygons[j]).size())
-            {
-                // make sure this poly doesn't intersect any holes. if it does, it's probably a nested sector and that will be handled separately.
-                bool ishole = true;
-                for (int k = 0; k < holes.size(); k++)
-                {
-                    if (holes[k].intersected(polygons[j]).size())
-                    {
-                        ishole = false;
-                        break;
-                    }
-                }
-
-                if (!ishole)
-                    continue;
-
-                QPolygonF& hole = polygons[j];
-                // add hole
-                holes.append(hole);
-                // remove hole from polygons list
-                polygons.removeAt(j);
-                j--;
-            }
-        }
-
-        QxPoly2Tri p2tri;
-        QList<QPointF> steinerPoints;
-
-        p2tri.triangulate(poly, holes, steinerPoints);
-
-        // make GL array now
-        QVector<int> tri_indices = p2tri.indices();
-        QVector<QPointF> tri_points = p2tri.points();
-        for (int j = 0; j < tri_indices.size(); j++)
-        {
-            GLVertex v;
-            v.x = tri_points[tri_indices[j]].x();
-            v.y = -tri_points[tri_indices[j]].y();
-            v.z = 0;
-            v.r = v.g = v.b = 255;
-            v.a = 64;
-            v.u = v.v = 0; // todo: set texture coordinates based on 64 grid
-            triangles.vertices.append(v);
-        }
-
-        polygons.removeAt(i);
-        i--;
-    }
-
-    updateBoundingBox();
-    linedefs = spt.getAllLinedefs();
-    for (int i = 0; i < linedefs.size(); i++)
-    {
-        DoomMapVertex* v1 = linedefs[i]->getV1();
-        DoomMapVertex* v2 = linedefs[i]->getV2();
-        if (!vertices.contains(v1))
-            vertices.append(v1);
-        if (!vertices.contains(v2))
-            vertices.append(v2);
-    }
-
-    for (int i = 0; i < linedefs.size(); i++)
-    {
-        DoomMapSidedef* sidefront = linedefs[i]->getFront();
-        DoomMapSidedef* sideback = linedefs[i]->getBack();
-        if (sidefront) sidefront->glupdate = true;
-        if (sideback) sideback->glupdate = true;
-    }
-
-    glupdate = true;
-}
+#include "doommap.h"
+#include "nodebuilder.h"
+#include "maploadreport.h"
+#include "triangulator.h"
+#include "geometry.h"
+#include "doommapjournal.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QVector>
+#include <QPolygonF>
+#include <QPointF>
+#include <QLineF>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QThreadStorage>
+#include <cmath>
+#include <algorithm>
+
+// geometry edits outside of actions (dragging) rebuild nodes once nothing moved for this long, in ms
+static const int DoomMap_NodesDelay = 500;
+
+// thing sizes from the doom 2 definitions, sorted by type. types that aren't here have the usual pickup size.
+struct DoomMapThings_TypeSize
+{
+    int type;
+    int radius;
+    int height;
+};
+
+static const DoomMapThings_TypeSize DoomMapThings_TypeSizes[] =
+{
+    { 1, 16, 56 }, { 2, 16, 56 }, { 3, 16, 56 }, { 4, 16, 56 }, // player starts
+    { 7, 128, 100 }, // spider mastermind
+    { 9, 20, 56 }, // shotgun guy
+    { 11, 16, 56 }, // deathmatch start
+    { 16, 40, 110 }, // cyberdemon
+    { 25, 16, 16 }, { 26, 16, 16 }, { 27, 16, 16 }, { 28, 16, 16 }, { 29, 16, 16 }, // impaled bodies, skulls
+    { 30, 16, 16 }, { 31, 16, 16 }, { 32, 16, 16 }, { 33, 16, 16 }, // pillars
+    { 35, 16, 16 }, { 36, 16, 16 }, { 37, 16, 16 }, // candelabra, pillars
+    { 41, 16, 16 }, { 42, 16, 16 }, { 43, 16, 16 }, { 44, 16, 16 }, { 45, 16, 16 }, { 46, 16, 16 }, { 47, 16, 16 }, { 48, 16, 16 }, // trees, torches, tech column
+    { 49, 16, 68 }, { 50, 16, 84 }, { 51, 16, 84 }, { 52, 16, 68 }, { 53, 16, 52 }, // hanging, blocking
+    { 54, 32, 16 }, // big tree
+    { 55, 16, 16 }, { 56, 16, 16 }, { 57, 16, 16 }, // short torches
+    { 58, 30, 56 }, // spectre
+    { 59, 20, 84 }, { 60, 20, 68 }, { 61, 20, 52 }, { 62, 20, 52 }, { 63, 16, 68 }, // hanging, not blocking
+    { 64, 20, 56 }, // arch-vile
+    { 65, 20, 56 }, // chaingunner
+    { 66, 20, 56 }, // revenant
+    { 67, 48, 64 }, // mancubus
+    { 68, 64, 64 }, // arachnotron
+    { 69, 24, 64 }, // hell knight
+    { 70, 16, 16 }, // burning barrel
+    { 71, 31, 56 }, // pain elemental
+    { 72, 16, 72 }, // commander keen
+    { 73, 16, 88 }, { 74, 16, 88 }, { 75, 16, 64 }, { 76, 16, 64 }, { 77, 16, 64 }, { 78, 16, 64 }, // hanging bodies
+    { 84, 20, 56 }, // wolfenstein ss
+    { 85, 16, 16 }, { 86, 16, 16 }, // tech lamps
+    { 87, 20, 32 }, // monster spawn spot
+    { 88, 16, 16 }, // boss brain
+    { 89, 20, 32 }, // monster spawner
+    { 2035, 10, 42 }, // barrel
+    { 3001, 20, 56 }, // imp
+    { 3002, 30, 56 }, // demon
+    { 3003, 24, 64 }, // baron of hell
+    { 3004, 20, 56 }, // zombieman
+    { 3005, 31, 56 }, // cacodemon
+    { 3006, 16, 56 }, // lost soul
+};
+
+static bool DoomMapThings_TypeLess(const DoomMapThings_TypeSize& a, int type)
+{
+    return a.type < type;
+}
+
+void DoomMapThings::getTypeSize(int type, float& radius, float& height)
+{
+    const DoomMapThings_TypeSize* begin = DoomMapThings_TypeSizes;
+    const DoomMapThings_TypeSize* end = begin + sizeof(DoomMapThings_TypeSizes) / sizeof(DoomMapThings_TypeSizes[0]);
+    const DoomMapThings_TypeSize* size = std::lower_bound(begin, end, type, DoomMapThings_TypeLess);
+    if (size != end && size->type == type)
+    {
+        radius = size->radius;
+        height = size->height;
+        return;
+    }
+
+    radius = 20;
+    height = 16;
+}
+
+DoomMap::DoomMap()
+{
+    type = Doom;
+    arenaWaste = 0;
+    rejectSize = 0;
+    topologyDirty = true;
+    intersectionsDirty = true;
+    textureIndexDirty = true;
+    tagIndexDirty = true;
+    gridDirty = true;
+    adjacencyDirty = true;
+    nodesDirty = false;
+    journal = new DoomMapJournal();
+    journalPaused = false;
+}
+
+DoomMap::~DoomMap()
+{
+    delete journal;
+}
+
+DoomMap::DoomMap(WADFile *wad, QString name)
+{
+    arenaWaste = 0;
+    rejectSize = 0;
+    topologyDirty = true;
+    intersectionsDirty = true;
+    textureIndexDirty = true;
+    tagIndexDirty = true;
+    gridDirty = true;
+    adjacencyDirty = true;
+    nodesDirty = false;
+    journal = new DoomMapJournal();
+    journalPaused = false;
+
+    // find the last name.
+    int snum = wad->getSize();
+    while (true)
+    {
+        int num = wad->getLastNumForName(name, snum);
+        snum = num-1;
+
+        WADEntry* nextent = wad->getEntry(num+1);
+        if (!nextent)
+            continue;
+
+        if (nextent->getName().toUpper() == "THINGS") // classic map
+        {
+            bool validmap = true;
+            QStringList entriesOrder = QStringList() << "THINGS" << "LINEDEFS" << "SIDEDEFS" << "VERTEXES" << "SEGS" << "SSECTORS" << "NODES" << "SECTORS" << "REJECT" << "BLOCKMAP";
+            WADEntry* entries[10] = {0};
+            entries[0] = nextent;
+            for (int i = 1; i < entriesOrder.size(); i++)
+            {
+                WADEntry* ent = wad->getEntry(num+1+i);
+                if (!ent)
+                {
+                    validmap = false;
+                    break;
+                }
+
+                entries[i] = ent;
+            }
+
+            if (!validmap)
+                continue;
+
+            //
+            // check the presence of BEHAVIOR
+            //hasbehavior = wad->getEntry(num+entriesOrder.size()) && (wad->getEntry(num+entriesOrder.size())->getName().toUpper() == "BEHAVIOR");
+            WADEntry* behent = wad->getEntry(num+entriesOrder.size()+1);
+            if (behent && behent->getName().toUpper() == "BEHAVIOR") // hexen map
+            {
+                behavior = behent->getData();
+                WADEntry* scriptsent = wad->getEntry(num+entriesOrder.size()+2);
+                if (scriptsent && scriptsent->getName().toUpper() == "SCRIPTS")
+                    scripts = QString::fromUtf8(scriptsent->getData());
+                type = Hexen;
+            }
+            else type = Doom;
+
+            // load the map.
+            QBuffer _things(&entries[0]->getData());
+            QBuffer _linedefs(&entries[1]->getData());
+            QBuffer _sidedefs(&entries[2]->getData());
+            QBuffer _vertexes(&entries[3]->getData());
+            QBuffer _sectors(&entries[7]->getData());
+            _things.open(QIODevice::ReadOnly);
+            _linedefs.open(QIODevice::ReadOnly);
+            _sidedefs.open(QIODevice::ReadOnly);
+            _vertexes.open(QIODevice::ReadOnly);
+            _sectors.open(QIODevice::ReadOnly);
+
+            {
+                MapLoadPhase phase("read lumps");
+                initClassic(&_things, &_linedefs, &_sidedefs, &_vertexes, &_sectors);
+            }
+
+            {
+                MapLoadPhase phase("unpack sidedefs");
+                unpackSidedefs();
+            }
+
+            // load the nodes. this needs sidedefs to be already unpacked.
+            QBuffer _segs(&entries[4]->getData());
+            QBuffer _ssectors(&entries[5]->getData());
+            QBuffer _nodes(&entries[6]->getData());
+            _segs.open(QIODevice::ReadOnly);
+            _ssectors.open(QIODevice::ReadOnly);
+            _nodes.open(QIODevice::ReadOnly);
+
+            {
+                MapLoadPhase phase("read nodes");
+                if (!nodes.load(this, &_segs, &_ssectors, &_nodes))
+                    qDebug("DoomMap: no usable nodes in %s", name.toUtf8().data());
+
+                initReject(entries[8]->getData());
+            }
+            break;
+        }
+        else if (nextent->getName().toUpper() == "TEXTMAP") // textmap
+        {
+            int endnum = wad->getNumForName("ENDMAP", num+1);
+            if (endnum < 0)
+                continue; // invalid map
+            int behnum = wad->getNumForName("BEHAVIOR", num+1);
+            int scriptsnum = wad->getNumForName("SCRIPTS", num+1);
+            if (behnum >= 0 && behnum < endnum)
+                behavior = wad->getEntry(behnum)->getData();
+            if (scriptsnum >= 0 && scriptsnum < endnum)
+                scripts = QString::fromUtf8(wad->getEntry(scriptsnum)->getData());
+            type = UDMF;
+
+            // load the map
+            initUDMF(QString::fromUtf8(nextent->getData()));
+            break;
+        }
+        else continue;
+    }
+
+    // no usable nodes in the map, make our own
+    if (!nodes.isValid())
+    {
+        MapLoadPhase phase("build nodes");
+        buildNodes();
+    }
+
+    {
+        MapLoadPhase phase("adjacency");
+        updateAdjacency();
+    }
+
+    {
+        MapLoadPhase phase("indices");
+        getTextureIndex();
+        getTagIndex();
+    }
+
+    {
+        MapLoadPhase phase("topology");
+        int mixed = getTopology().getMixedLoopCount();
+        if (mixed)
+            qDebug("DoomMap: %d line loops in %s are not closed", mixed, name.toUtf8().data());
+    }
+
+    {
+        MapLoadPhase phase("intersections");
+        const DoomMapIntersections& in = getIntersections();
+        if (in.intersections.size())
+        {
+            qDebug("DoomMap: %d crossing, %d overlapping and %d touching lines in %s",
+                   in.getCount(DoomMapIntersection::Crossing), in.getCount(DoomMapIntersection::Overlap),
+                   in.getCount(DoomMapIntersection::Touch), name.toUtf8().data());
+        }
+    }
+
+    // triangulate sectors
+    {
+        MapLoadPhase phase("triangulate");
+        triangulateSectors();
+        // the weld above marked sectors, but everything is done now
+        dirtySectors.clear();
+        dirtySectorBits.fill(false);
+    }
+
+    {
+        MapLoadPhase phase("grid");
+        getGrid();
+    }
+
+    int numtriangles = 0;
+    for (int i = 0; i < sectors.size(); i++)
+        numtriangles += sectors[i].triangles.size() / 3;
+
+    MapLoadReport& report = MapLoadReport::get();
+    report.setCounter("vertices", vertices.size());
+    report.setCounter("linedefs", linedefs.size());
+    report.setCounter("sidedefs", sidedefs.size());
+    report.setCounter("sectors", sectors.size());
+    report.setCounter("things", things.size());
+    report.setCounter("segs", nodes.segs.size());
+    report.setCounter("subsectors", nodes.subsectors.size());
+    report.setCounter("nodes", nodes.nodes.size());
+    report.setCounter("triangles", numtriangles);
+    report.setCounter("arena blocks", arena.getBlockCount());
+    report.setCounter("loops", getTopology().loops.size());
+    report.setCounter("intersections", getIntersections().intersections.size());
+}
+
+bool DoomMap::buildNodes()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // nothing to gain from trying again until the next edit
+    nodesDirty = false;
+
+    NodeBuilder builder(this);
+    if (!builder.build(nodes))
+        return false;
+
+    qDebug("DoomMap: built %d nodes, %d subsectors, %d segs in %dms", nodes.nodes.size(), nodes.subsectors.size(), nodes.segs.size(), (int)timer.elapsed());
+    return true;
+}
+
+void DoomMap::buildSectorLinedefs()
+{
+    int numsectors = sectors.size();
+    sectorLinedefOffsets.fill(0, numsectors+1);
+
+    // sectors of both sides for every linedef, -1 if none
+    QVector<int> linesectors(linedefs.size()*2);
+    for (int i = 0; i < linedefs.size(); i++)
+    {
+        int s[2] = { -1, -1 };
+        int sd[2] = { linedefs[i].sidefront, linedefs[i].sideback };
+        for (int j = 0; j < 2; j++)
+        {
+            if (sd[j] >= 0 && sd[j] < sidedefs.size() && sidedefs[sd[j]].sector >= 0 && sidedefs[sd[j]].sector < numsectors)
+                s[j] = sidedefs[sd[j]].sector;
+        }
+
+        if (s[1] == s[0])
+            s[1] = -1;
+
+        linesectors[i*2] = s[0];
+        linesectors[i*2+1] = s[1];
+        for (int j = 0; j < 2; j++)
+        {
+            if (s[j] >= 0)
+                sectorLinedefOffsets[s[j]+1]++;
+        }
+    }
+
+    for (int i = 0; i < numsectors; i++)
+        sectorLinedefOffsets[i+1] += sectorLinedefOffsets[i];
+
+    sectorLinedefs.resize(sectorLinedefOffsets[numsectors]);
+    QVector<int> next = sectorLinedefOffsets;
+    for (int i = 0; i < linesectors.size(); i++)
+    {
+        if (linesectors[i] >= 0)
+            sectorLinedefs[next[linesectors[i]]++] = i / 2;
+    }
+}
+
+void DoomMap::buildVertexLinedefs()
+{
+    int numvertices = vertices.size();
+    vertexLinedefOffsets.fill(0, numvertices+1);
+    for (int i = 0; i < linedefs.size(); i++)
+    {
+        int v[2] = { linedefs[i].v1, linedefs[i].v2 };
+        for (int j = 0; j < 2; j++)
+        {
+            if (v[j] >= 0 && v[j] < numvertices && (j == 0 || v[1] != v[0]))
+                vertexLinedefOffsets[v[j]+1]++;
+        }
+    }
+
+    for (int i = 0; i < numvertices; i++)
+        vertexLinedefOffsets[i+1] += vertexLinedefOffsets[i];
+
+    vertexLinedefs.resize(vertexLinedefOffsets[numvertices]);
+    QVector<int> next = vertexLinedefOffsets;
+    for (int i = 0; i < linedefs.size(); i++)
+    {
+        int v[2] = { linedefs[i].v1, linedefs[i].v2 };
+        for (int j = 0; j < 2; j++)
+        {
+            if (v[j] >= 0 && v[j] < numvertices && (j == 0 || v[1] != v[0]))
+                vertexLinedefs[next[v[j]]++] = i;
+        }
+    }
+}
+
+int DoomMap::sectorAt(float x, float y) const
+{
+    int subsector = nodes.subsectorAt(x, y);
+    if (subsector < 0)
+        return -1;
+    return nodes.subsectors[subsector].sector;
+}
+
+struct DoomMap_SectorsAtChunk
+{
+    int start;
+    int end;
+};
+
+struct DoomMap_SectorsAtJob
+{
+    typedef void result_type;
+
+    const DoomMap* map;
+    const QVector<QPointF>* points;
+    int* out;
+
+    void operator()(const DoomMap_SectorsAtChunk& chunk) const
+    {
+        for (int i = chunk.start; i < chunk.end; i++)
+            out[i] = map->sectorAt((*points)[i].x(), (*points)[i].y());
+    }
+};
+
+struct DoomMap_TriangulateJob
+{
+    typedef void result_type;
+
+    const DoomMap* map;
+    const DoomMapIntersections* intersections;
+    const int* sectors;
+    DoomMapSectorTriangles* results;
+
+    void operator()(int job) const
+    {
+        map->sectors.constData()[sectors[job]].computeTriangles(map, *intersections, results[job]);
+    }
+};
+
+void DoomMap::triangulateSectors()
+{
+    QVector<int> indices(sectors.size());
+    for (int i = 0; i < indices.size(); i++)
+        indices[i] = i;
+
+    triangulateSectors(indices);
+}
+
+void DoomMap::triangulateSectors(const QVector<int>& indices)
+{
+    // sectors only read the map while triangulating. everything they change is applied after all threads are done.
+    // intersections are checked by every sector, so they are updated here before the threads start and passed as const.
+    const DoomMapIntersections& current = getIntersections();
+    QVector<DoomMapSectorTriangles> results(indices.size());
+    QVector<int> jobs(indices.size());
+    for (int i = 0; i < jobs.size(); i++)
+        jobs[i] = i;
+
+    DoomMap_TriangulateJob job;
+    job.map = this;
+    job.intersections = &current;
+    job.sectors = indices.constData();
+    job.results = results.data();
+    QtConcurrent::blockingMap(jobs, job);
+
+    for (int i = 0; i < indices.size(); i++)
+    {
+        sectors[indices[i]].applyTriangles(this, results[i]);
+        if (!gridDirty)
+            grid.updateSector(indices[i]);
+    }
+
+    // at least half of the arena is old data, copy what's left to a new one
+    if (arenaWaste > 1024*1024 && arenaWaste*2 > arena.getUsed())
+        compactArena();
+}
+
+void DoomMap::compactArena()
+{
+    DoomMapArena newArena;
+    for (int i = 0; i < sectors.size(); i++)
+    {
+        DoomMapSector& sector = sectors[i];
+        sector.triangles = newArena.copy(sector.triangles.data, sector.triangles.size());
+        sector.vertices = newArena.copy(sector.vertices.data, sector.vertices.size());
+    }
+
+    arena.swap(newArena);
+    arenaWaste = 0;
+}
+
+const DoomMapTopology& DoomMap::getTopology()
+{
+    if (topologyDirty)
+    {
+        topology.build(this);
+        topologyDirty = false;
+    }
+
+    return topology;
+}
+
+const DoomMapIntersections& DoomMap::getIntersections()
+{
+    if (intersectionsDirty)
+    {
+        intersections.build(this);
+        intersectionsDirty = false;
+    }
+
+    return intersections;
+}
+
+const DoomMapTextureIndex& DoomMap::getTextureIndex()
+{
+    if (textureIndexDirty)
+    {
+        textureIndex.build(this);
+        textureIndexDirty = false;
+    }
+
+    return textureIndex;
+}
+
+const DoomMapTagIndex& DoomMap::getTagIndex()
+{
+    if (tagIndexDirty)
+    {
+        tagIndex.build(this);
+        tagIndexDirty = false;
+    }
+
+    return tagIndex;
+}
+
+const DoomMapGrid& DoomMap::getGrid()
+{
+    if (gridDirty)
+    {
+        grid.build(this);
+        gridDirty = false;
+    }
+
+    return grid;
+}
+
+QVector<int> DoomMap::getSectorsWithin(float x, float y, float dist)
+{
+    // the grid has sectors with the bounding box in range, only their vertices are checked
+    QVector<int> result = getGrid().queryRadius(DoomMapGrid::Sectors, x, y, dist);
+    int count = 0;
+    for (int i = 0; i < result.size(); i++)
+    {
+        if (sectors[result[i]].isAnyWithin(this, x, y, dist))
+            result[count++] = result[i];
+    }
+
+    result.resize(count);
+    return result;
+}
+
+void DoomMap::markGeometryChanged()
+{
+    // visibility from the old geometry would hide sectors that can be seen now
+    reject.clear();
+    rejectSize = 0;
+    nodes.invalidate();
+    nodesDirty = true;
+    nodesTimer.start();
+    topologyDirty = true;
+    intersectionsDirty = true;
+}
+
+void DoomMap::updateAdjacency()
+{
+    buildSectorLinedefs();
+    buildVertexLinedefs();
+    adjacencyDirty = false;
+}
+
+void DoomMap::markSectorDirty(int sector)
+{
+    if (sector < 0 || sector >= sectors.size())
+        return;
+
+    if (dirtySectorBits.size() != sectors.size())
+        dirtySectorBits.resize(sectors.size());
+
+    if (dirtySectorBits.testBit(sector))
+        return;
+
+    dirtySectorBits.setBit(sector);
+    dirtySectors.append(sector);
+}
+
+void DoomMap::markLinedefDirty(int linedef)
+{
+    if (linedef < 0 || linedef >= linedefs.size())
+        return;
+
+    DoomMapSidedef* front = linedefs[linedef].getFront(this);
+    DoomMapSidedef* back = linedefs[linedef].getBack(this);
+    if (front) markSectorDirty(front->sector);
+    if (back) markSectorDirty(back->sector);
+}
+
+void DoomMap::setVertexPosition(int vertex, float x, float y)
+{
+    if (vertex < 0 || vertex >= vertices.size())
+        return;
+
+    // moving a vertex doesn't change which lines it has, so adjacency is only rebuilt if something else changed it.
+    if (adjacencyDirty)
+        updateAdjacency();
+
+    for (int i = vertexLinedefOffsets[vertex]; i < vertexLinedefOffsets[vertex+1]; i++)
+        markLinedefDirty(vertexLinedefs[i]);
+
+    record(DoomMapDelta::VertexPosition, vertex,
+           DoomMapDelta::fromFloat(vertices[vertex].x), DoomMapDelta::fromFloat(vertices[vertex].y),
+           DoomMapDelta::fromFloat(x), DoomMapDelta::fromFloat(y));
+    vertices[vertex].x = x;
+    vertices[vertex].y = y;
+    markGeometryChanged();
+
+    if (!gridDirty)
+    {
+        grid.updateVertex(vertex);
+        for (int i = vertexLinedefOffsets[vertex]; i < vertexLinedefOffsets[vertex+1]; i++)
+            grid.updateLinedef(vertexLinedefs[i]);
+    }
+}
+
+void DoomMap::setLinedefVertices(int linedef, int v1, int v2)
+{
+    if (linedef < 0 || linedef >= linedefs.size())
+        return;
+
+    markLinedefDirty(linedef);
+    record(DoomMapDelta::LinedefVertices, linedef, linedefs[linedef].v1, linedefs[linedef].v2, v1, v2);
+    linedefs[linedef].v1 = v1;
+    linedefs[linedef].v2 = v2;
+    adjacencyDirty = true;
+    markGeometryChanged();
+    if (!gridDirty)
+        grid.updateLinedef(linedef);
+}
+
+void DoomMap::setLinedefSidedefs(int linedef, int front, int back)
+{
+    if (linedef < 0 || linedef >= linedefs.size())
+        return;
+
+    markLinedefDirty(linedef);
+    record(DoomMapDelta::LinedefSidedefs, linedef, linedefs[linedef].sidefront, linedefs[linedef].sideback, front, back);
+    linedefs[linedef].sidefront = front;
+    linedefs[linedef].sideback = back;
+    markLinedefDirty(linedef);
+    adjacencyDirty = true;
+    markGeometryChanged();
+}
+
+void DoomMap::setSidedefSector(int sidedef, int sector)
+{
+    if (sidedef < 0 || sidedef >= sidedefs.size())
+        return;
+
+    // sidedefs don't know their linedefs. this is a rare edit, so just look for them.
+    for (int i = 0; i < linedefs.size(); i++)
+    {
+        if (linedefs[i].sidefront == sidedef || linedefs[i].sideback == sidedef)
+            markLinedefDirty(i);
+    }
+
+    record(DoomMapDelta::SidedefSector, sidedef, sidedefs[sidedef].sector, 0, sector, 0);
+    sidedefs[sidedef].sector = sector;
+    markSectorDirty(sector);
+    adjacencyDirty = true;
+    markGeometryChanged();
+}
+
+void DoomMap::setSidedefTexture(int sidedef, int part, int texture)
+{
+    if (sidedef < 0 || sidedef >= sidedefs.size() || part < 0 || part >= DoomMapTextureIndex::NumSidedefParts)
+        return;
+
+    DoomMapSidedef& sd = sidedefs[sidedef];
+    int* fields[DoomMapTextureIndex::NumSidedefParts] = { &sd.texturetop, &sd.texturebottom, &sd.texturemiddle };
+    int& field = *fields[part];
+    if (field == texture)
+        return;
+
+    record(DoomMapDelta::SidedefTexture, sidedef, field, part, texture, part);
+    if (!textureIndexDirty)
+        textureIndex.updateSidedef(sidedef, part, field, texture);
+    field = texture;
+    sd.glupdate = true;
+}
+
+void DoomMap::setSectorTexture(int sector, int plane, int texture)
+{
+    if (sector < 0 || sector >= sectors.size() || plane < 0 || plane >= DoomMapTextureIndex::NumSectorPlanes)
+        return;
+
+    DoomMapSector& sec = sectors[sector];
+    int& field = (plane == DoomMapTextureIndex::Floor) ? sec.texturefloor : sec.textureceiling;
+    if (field == texture)
+        return;
+
+    record(DoomMapDelta::SectorTexture, sector, field, plane, texture, plane);
+    if (!textureIndexDirty)
+        textureIndex.updateSector(sector, plane, field, texture);
+    field = texture;
+    sec.glupdate = true;
+}
+
+int DoomMap::replaceTexture(int from, int to)
+{
+    if (from == to)
+        return 0;
+
+    // lists change while surfaces are moved to the other texture
+    const DoomMapTextureIndex& index = getTextureIndex();
+    QVector<int> sidedefSurfaces = index.getSidedefSurfaces(from);
+    QVector<int> sectorSurfaces = index.getSectorSurfaces(from);
+
+    beginAction("Replace texture");
+    for (int i = 0; i < sidedefSurfaces.size(); i++)
+        setSidedefTexture(DoomMapTextureIndex::getSidedef(sidedefSurfaces[i]), DoomMapTextureIndex::getSidedefPart(sidedefSurfaces[i]), to);
+    for (int i = 0; i < sectorSurfaces.size(); i++)
+        setSectorTexture(DoomMapTextureIndex::getSector(sectorSurfaces[i]), DoomMapTextureIndex::getSectorPlane(sectorSurfaces[i]), to);
+    endAction();
+
+    return sidedefSurfaces.size() + sectorSurfaces.size();
+}
+
+void DoomMap::markTextureChanged(int texture)
+{
+    const DoomMapTextureIndex& index = getTextureIndex();
+    const QVector<int>& sidedefSurfaces = index.getSidedefSurfaces(texture);
+    for (int i = 0; i < sidedefSurfaces.size(); i++)
+        sidedefs[DoomMapTextureIndex::getSidedef(sidedefSurfaces[i])].glupdate = true;
+    const QVector<int>& sectorSurfaces = index.getSectorSurfaces(texture);
+    for (int i = 0; i < sectorSurfaces.size(); i++)
+        sectors[DoomMapTextureIndex::getSector(sectorSurfaces[i])].glupdate = true;
+}
+
+void DoomMap::setSectorTag(int sector, int tag)
+{
+    if (sector < 0 || sector >= sectors.size() || sectors[sector].id == tag)
+        return;
+
+    record(DoomMapDelta::SectorTag, sector, sectors[sector].id, 0, tag, 0);
+    if (!tagIndexDirty)
+        tagIndex.update(DoomMapTagIndex::Sector, sector, sectors[sector].id, tag);
+    sectors[sector].id = tag;
+}
+
+void DoomMap::setLinedefId(int linedef, int id)
+{
+    if (linedef < 0 || linedef >= linedefs.size() || linedefs[linedef].id == id)
+        return;
+
+    record(DoomMapDelta::LinedefId, linedef, linedefs[linedef].id, 0, id, 0);
+    if (!tagIndexDirty)
+        tagIndex.update(DoomMapTagIndex::Linedef, linedef, linedefs[linedef].id, id);
+    linedefs[linedef].id = id;
+}
+
+void DoomMap::setThingId(int thing, int id)
+{
+    if (thing < 0 || thing >= things.size() || things.id[thing] == id)
+        return;
+
+    record(DoomMapDelta::ThingId, thing, things.id[thing], 0, id, 0);
+    if (!tagIndexDirty)
+        tagIndex.update(DoomMapTagIndex::Thing, thing, things.id[thing], id);
+    things.id[thing] = id;
+}
+
+// Hexen and ZDoom (UDMF) specials whose first argument is a sector tag, sorted.
+// doors, floors, ceilings, lifts, stairs, pillars, lights and sector properties. everything else uses arg0 for something else (tids, line ids, scripts).
+static const int DoomMap_SectorTagSpecials[] =
+{
+    10, 11, 12, 13, 14, // Door_*
+    20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, // Floor_*, Stairs_*, Pillar_*
+    34, 35, 36, 37, 38, // ClearForceField, Floor_*ByValueTimes8, Floor_MoveToValue, Ceiling_Waggle
+    40, 41, 42, 43, 44, 45, 46, 47, // Ceiling_*, Floor_CrushStop
+    60, 61, 62, 63, 64, 65, 66, 67, 68, 69, // Plat_*, Floor_*Instant, *_MoveToValueTimes8
+    94, 95, 96, 97, 99, // Pillar_BuildAndCrush, FloorAndCeiling_*, Ceiling_LowerAndCrushDist, Floor_RaiseAndCrushDoom
+    104, 105, 106, // Ceiling_CrushAndRaiseSilentDist, Door_WaitRaise, Door_WaitClose
+    110, 111, 112, 113, 114, 115, 116, 117, // Light_*
+    138, 140, 160, 168, 172, // Floor_Waggle, Sector_ChangeSound, Sector_Set3DFloor, Ceiling_CrushAndRaiseDist, Plat_UpNearestWaitDownStay
+    185, 186, 187, 188, 189, 190, // Sector_SetRotation, *Panning, *Scale, Static_Init
+    192, 193, 194, 195, 196, 197, 198, 199, // Ceiling_*
+    200, 201, 202, 203, 204, 205, 206, 207, // Generic_*, Plat_*Lip
+    212, 213, 214, 216, 218, 219, 220, // Sector_SetColor, Fade, Damage, Gravity, Wind, Friction, Current
+    228, 230, 231, 232, 233, 234, 235, 236, // Plat_*Tx, Plat_ToggleCeiling, Light_StrobeDoom, Light_*Neighbor, Floor_Transfer*
+    238, 239, 240, 241, 242, // Floor_*
+    245, 246, 247, // Elevator_*
+    250, 251, 252, 253, 254, 255, // Floor_Donut, FloorAndCeiling_LowerRaise, Ceiling_*
+    256, 257, 258, 259, 260, 261, // Floor_*
+    262, 263, 264, 265, 266, 267, 268, 269 // Ceiling_*
+};
+
+static bool DoomMap_IsSectorTagSpecial(int special)
+{
+    const int* begin = DoomMap_SectorTagSpecials;
+    const int* end = begin + sizeof(DoomMap_SectorTagSpecials) / sizeof(DoomMap_SectorTagSpecials[0]);
+    return std::binary_search(begin, end, special);
+}
+
+QVector<int> DoomMap::getLinedefTargetSectors(int linedef)
+{
+    if (linedef < 0 || linedef >= linedefs.size() || !linedefs[linedef].special)
+        return QVector<int>();
+
+    const DoomMapLinedef& ld = linedefs[linedef];
+    if (type == Hexen || type == UDMF)
+    {
+        if (!DoomMap_IsSectorTagSpecial(ld.special))
+            return QVector<int>();
+        return getTagIndex().get(DoomMapTagIndex::Sector, ld.arg0);
+    }
+
+    return getTagIndex().get(DoomMapTagIndex::Sector, ld.id);
+}
+
+int DoomMap::getSidedefLinedef(int sidedef)
+{
+    if (sidedef < 0 || sidedef >= sidedefs.size())
+        return -1;
+
+    int sector = sidedefs[sidedef].sector;
+    if (sector < 0 || sector >= sectors.size())
+        return -1;
+
+    if (adjacencyDirty)
+        updateAdjacency();
+
+    for (int i = sectorLinedefOffsets[sector]; i < sectorLinedefOffsets[sector+1]; i++)
+    {
+        const DoomMapLinedef& ld = linedefs[sectorLinedefs[i]];
+        if (ld.sidefront == sidedef || ld.sideback == sidedef)
+            return sectorLinedefs[i];
+    }
+
+    return -1;
+}
+
+bool DoomMap::updateNodes(bool force)
+{
+    if (!nodesDirty)
+        return false;
+
+    if (!force && nodesTimer.elapsed() < DoomMap_NodesDelay)
+        return false;
+
+    buildNodes();
+    return true;
+}
+
+int DoomMap::updateDirtySectors()
+{
+    // nodes only depend on lines, so they're checked even if no sector needs triangulation
+    updateNodes(false);
+
+    if (dirtySectors.isEmpty())
+        return 0;
+
+    if (adjacencyDirty)
+        updateAdjacency();
+
+    QVector<int> batch;
+    batch.swap(dirtySectors);
+    for (int i = 0; i < batch.size(); i++)
+    {
+        if (batch[i] < dirtySectorBits.size())
+            dirtySectorBits.clearBit(batch[i]);
+    }
+
+    // sectors might have been removed since they were marked
+    for (int i = 0; i < batch.size(); i++)
+    {
+        if (batch[i] >= sectors.size())
+        {
+            batch.removeAt(i);
+            i--;
+        }
+    }
+
+    std::sort(batch.begin(), batch.end());
+    triangulateSectors(batch);
+    return batch.size();
+}
+
+static quint64 DoomMap_CellKey(qint32 x, qint32 y)
+{
+    return ((quint64)(quint32)x << 32) | (quint32)y;
+}
+
+static void DoomMap_RemapLinedefVertices(QVector<DoomMapLinedef>& linedefs, const QVector<int>& newIndex)
+{
+    for (int i = 0; i < linedefs.size(); i++)
+    {
+        DoomMapLinedef& linedef = linedefs[i];
+        if (linedef.v1 >= 0 && linedef.v1 < newIndex.size()) linedef.v1 = newIndex[linedef.v1];
+        if (linedef.v2 >= 0 && linedef.v2 < newIndex.size()) linedef.v2 = newIndex[linedef.v2];
+    }
+}
+
+// sectors that aren't retriangulated after the weld keep their vertex lists, so those are renumbered too
+static void DoomMap_RemapSectorVertices(QVector<DoomMapSector>& sectors, const QVector<int>& newIndex)
+{
+    for (int i = 0; i < sectors.size(); i++)
+    {
+        DoomMapSpan<int>& sv = sectors[i].vertices;
+        for (int j = 0; j < sv.size(); j++)
+        {
+            if (sv[j] >= 0 && sv[j] < newIndex.size())
+                sv[j] = newIndex[sv[j]];
+        }
+    }
+}
+
+static void DoomMap_SaveWeldProperties(const DoomMapProperties& properties, DoomMapProperties::Kind kind, const QVector<int>& indices, QVector<DoomMapWeldProperty>& out)
+{
+    for (int i = 0; i < indices.size(); i++)
+    {
+        QVector<int> keys = properties.getKeys(kind, indices[i]);
+        for (int j = 0; j < keys.size(); j++)
+        {
+            DoomMapWeldProperty property;
+            property.index = indices[i];
+            property.key = keys[j];
+            property.value = properties.get(kind, indices[i], keys[j]);
+            out.append(property);
+        }
+    }
+}
+
+static void DoomMap_RestoreWeldProperties(DoomMapProperties& properties, DoomMapProperties::Kind kind, const QVector<DoomMapWeldProperty>& saved)
+{
+    for (int i = 0; i < saved.size(); i++)
+        properties.set(kind, saved[i].index, saved[i].key, saved[i].value);
+}
+
+int DoomMap::findWeldTargets(float tolerance, QVector<int>& target) const
+{
+    // every vertex is merged into the first vertex before it that's close enough.
+    // only vertices that stay are put into the hash, and they are at least tolerance apart, so each cell has very few of them.
+    int numvertices = vertices.size();
+    double cellsize = tolerance > 0 ? tolerance : 1;
+    double tolerance2 = (double)tolerance * tolerance;
+    QHash<quint64, int> cells;
+    cells.reserve(numvertices);
+    QVector<int> nextInCell(numvertices, -1);
+    target.resize(numvertices);
+    int welded = 0;
+    for (int i = 0; i < numvertices; i++)
+    {
+        const DoomMapVertex& v = vertices[i];
+        qint32 cx = (qint32)floor(v.x / cellsize);
+        qint32 cy = (qint32)floor(v.y / cellsize);
+
+        target[i] = i;
+        for (int j = 0; j < 9 && target[i] == i; j++)
+        {
+            for (int k = cells.value(DoomMap_CellKey(cx + j%3 - 1, cy + j/3 - 1), -1); k >= 0; k = nextInCell[k])
+            {
+                double dx = (double)vertices[k].x - v.x;
+                double dy = (double)vertices[k].y - v.y;
+                if (dx*dx + dy*dy <= tolerance2)
+                {
+                    target[i] = k;
+                    break;
+                }
+            }
+        }
+
+        if (target[i] != i)
+        {
+            welded++;
+            continue;
+        }
+
+        quint64 key = DoomMap_CellKey(cx, cy);
+        nextInCell[i] = cells.value(key, -1);
+        cells.insert(key, i);
+    }
+
+    return welded;
+}
+
+int DoomMap::countWeldVertices(float tolerance) const
+{
+    QVector<int> target;
+    return findWeldTargets(tolerance, target);
+}
+
+DoomMapWeldResult DoomMap::weldVertices(float tolerance)
+{
+    if (adjacencyDirty)
+        updateAdjacency();
+
+    DoomMapWeldResult result;
+    int numvertices = vertices.size();
+    QVector<int> target;
+    result.vertices = findWeldTargets(tolerance, target);
+    if (!result.vertices)
+        return result;
+
+    // the weld is worked out in the current numbering first, and then applied the same way as redo does it.
+    DoomMapWeld weld;
+    for (int i = 0; i < numvertices; i++)
+    {
+        if (target[i] == i)
+            continue;
+        weld.vertices.append(i);
+        weld.targets.append(target[i]);
+        weld.vertexData.append(vertices[i]);
+    }
+
+    // lines that become zero length are removed. lines between the same two vertices are merged into the first of them:
+    // it takes sidedefs for the sides it doesn't have, so two one-sided lines on top of each other become one two-sided line.
+    QHash<quint64, int> pairs;
+    pairs.reserve(linedefs.size());
+    QHash<int, int> changedRows;
+    for (int i = 0; i < linedefs.size(); i++)
+    {
+        const DoomMapLinedef& linedef = linedefs[i];
+        int v1 = (linedef.v1 >= 0 && linedef.v1 < numvertices) ? target[linedef.v1] : linedef.v1;
+        int v2 = (linedef.v2 >= 0 && linedef.v2 < numvertices) ? target[linedef.v2] : linedef.v2;
+        if (v1 == v2)
+        {
+            weld.linedefs.append(i);
+            weld.linedefData.append(linedef);
+            continue;
+        }
+
+        quint64 key = DoomMap_CellKey(qMin(v1, v2), qMax(v1, v2));
+        int first = pairs.value(key, -1);
+        if (first < 0)
+        {
+            pairs.insert(key, i);
+            if (v1 != linedef.v1 || v2 != linedef.v2)
+            {
+                changedRows.insert(i, weld.changed.size());
+                weld.changed.append(i);
+                weld.changedBefore.append(linedef);
+                weld.changedAfter.append(linedef);
+                weld.changedAfter.last().v1 = v1;
+                weld.changedAfter.last().v2 = v2;
+            }
+            continue;
+        }
+
+        int row = changedRows.value(first, -1);
+        if (row < 0)
+        {
+            // first line didn't move, but takes sides from this one now
+            row = weld.changed.size();
+            changedRows.insert(first, row);
+            weld.changed.append(first);
+            weld.changedBefore.append(linedefs[first]);
+            weld.changedAfter.append(linedefs[first]);
+        }
+
+        DoomMapLinedef& into = weld.changedAfter[row];
+        bool reversed = (into.v1 != v1);
+        int front = reversed ? linedef.sideback : linedef.sidefront;
+        int back = reversed ? linedef.sidefront : linedef.sideback;
+        if (into.sidefront < 0) into.sidefront = front;
+        else if (front >= 0 && front != into.sidefront)
+            result.sidedefs++;
+        if (into.sideback < 0) into.sideback = back;
+        else if (back >= 0 && back != into.sideback)
+            result.sidedefs++;
+        if (into.sidefront >= 0 && into.sideback >= 0)
+            into.twosided = true;
+
+        // the line that stays takes the action of the removed one if it has none
+        if (linedef.special || linedef.id)
+        {
+            if (!into.special && !into.id)
+            {
+                into.special = linedef.special;
+                into.id = linedef.id;
+                into.arg0 = linedef.arg0;
+                into.arg1 = linedef.arg1;
+                into.arg2 = linedef.arg2;
+                into.arg3 = linedef.arg3;
+                into.arg4 = linedef.arg4;
+            }
+            else if (into.special != linedef.special || into.id != linedef.id)
+                result.specials++;
+        }
+
+        weld.linedefs.append(i);
+        weld.linedefData.append(linedef);
+    }
+
+    // extra fields of removed components, so undo can put them back
+    DoomMap_SaveWeldProperties(properties, DoomMapProperties::Vertex, weld.vertices, weld.vertexProperties);
+    DoomMap_SaveWeldProperties(properties, DoomMapProperties::Linedef, weld.linedefs, weld.linedefProperties);
+
+    result.linedefs = weld.linedefs.size();
+    beginAction("Weld vertices");
+    applyWeld(weld, false);
+    if (!journalPaused)
+        journal->recordWeld(weld);
+    endAction();
+
+    return result;
+}
+
+QString DoomMapWeldResult::getSummary() const
+{
+    QString summary = QString("Welded %1 vertices, removed %2 linedefs").arg(vertices).arg(linedefs);
+    if (sidedefs)
+        summary += QString(", %1 sidedefs have no line left").arg(sidedefs);
+    if (specials)
+        summary += QString(", %1 line specials were dropped").arg(specials);
+    return summary + ".";
+}
+
+void DoomMap::markWeldDirty(const DoomMapWeld& weld)
+{
+    // sectors around removed vertices and the vertices they went to change shape, and so do the sectors of removed and merged lines.
+    // this has to run while the numbering from before the weld is in place.
+    for (int i = 0; i < weld.vertices.size(); i++)
+    {
+        int v[2] = { weld.vertices[i], weld.targets[i] };
+        for (int j = 0; j < 2; j++)
+        {
+            for (int k = vertexLinedefOffsets[v[j]]; k < vertexLinedefOffsets[v[j]+1]; k++)
+                markLinedefDirty(vertexLinedefs[k]);
+        }
+    }
+
+    for (int i = 0; i < weld.linedefs.size(); i++)
+        markLinedefDirty(weld.linedefs[i]);
+    for (int i = 0; i < weld.changed.size(); i++)
+        markLinedefDirty(weld.changed[i]);
+}
+
+void DoomMap::applyWeld(const DoomMapWeld& weld, bool undo)
+{
+    if (adjacencyDirty)
+        updateAdjacency();
+
+    // old is the numbering from before the weld, new is after it
+    int numremoved = weld.vertices.size();
+    int numvertices = undo ? vertices.size() + numremoved : vertices.size();
+    QVector<int> newIndex(numvertices);
+    QVector<int> oldIndex(numvertices - numremoved);
+    for (int i = 0, r = 0; i < numvertices; i++)
+    {
+        if (r < numremoved && weld.vertices[r] == i)
+        {
+            newIndex[i] = -1;
+            r++;
+            continue;
+        }
+        newIndex[i] = i - r;
+        oldIndex[i - r] = i;
+    }
+
+    int numlinedefs = undo ? linedefs.size() + weld.linedefs.size() : linedefs.size();
+    QVector<int> newLinedefIndex(numlinedefs);
+    QVector<int> oldLinedefIndex(numlinedefs - weld.linedefs.size());
+    for (int i = 0, r = 0; i < numlinedefs; i++)
+    {
+        if (r < weld.linedefs.size() && weld.linedefs[r] == i)
+        {
+            newLinedefIndex[i] = -1;
+            r++;
+            continue;
+        }
+        newLinedefIndex[i] = i - r;
+        oldLinedefIndex[i - r] = i;
+    }
+
+    if (!undo)
+    {
+        markWeldDirty(weld);
+
+        properties.remap(DoomMapProperties::Vertex, newIndex);
+        properties.remap(DoomMapProperties::Linedef, newLinedefIndex);
+        for (int i = 0; i < numremoved; i++)
+            newIndex[weld.vertices[i]] = newIndex[weld.targets[i]];
+
+        for (int i = 0; i < weld.changed.size(); i++)
+            linedefs[weld.changed[i]] = weld.changedAfter[i];
+
+        // removed vertices and linedefs go away, the rest moves down
+        QVector<DoomMapVertex> newVertices;
+        newVertices.reserve(oldIndex.size());
+        for (int i = 0; i < oldIndex.size(); i++)
+            newVertices.append(vertices[oldIndex[i]]);
+        vertices.swap(newVertices);
+
+        QVector<DoomMapLinedef> newLinedefs;
+        newLinedefs.reserve(oldLinedefIndex.size());
+        for (int i = 0; i < oldLinedefIndex.size(); i++)
+            newLinedefs.append(linedefs[oldLinedefIndex[i]]);
+        linedefs.swap(newLinedefs);
+
+        DoomMap_RemapLinedefVertices(linedefs, newIndex);
+        DoomMap_RemapSectorVertices(sectors, newIndex);
+    }
+    else
+    {
+        properties.remap(DoomMapProperties::Vertex, oldIndex);
+        properties.remap(DoomMapProperties::Linedef, oldLinedefIndex);
+        DoomMap_RestoreWeldProperties(properties, DoomMapProperties::Vertex, weld.vertexProperties);
+        DoomMap_RestoreWeldProperties(properties, DoomMapProperties::Linedef, weld.linedefProperties);
+
+        DoomMap_RemapLinedefVertices(linedefs, oldIndex);
+        DoomMap_RemapSectorVertices(sectors, oldIndex);
+
+        // removed vertices and linedefs go back where they were
+        QVector<DoomMapVertex> newVertices(numvertices);
+        for (int i = 0; i < oldIndex.size(); i++)
+            newVertices[oldIndex[i]] = vertices[i];
+        for (int i = 0; i < numremoved; i++)
+            newVertices[weld.vertices[i]] = weld.vertexData[i];
+        vertices.swap(newVertices);
+
+        QVector<DoomMapLinedef> newLinedefs(numlinedefs);
+        for (int i = 0; i < oldLinedefIndex.size(); i++)
+            newLinedefs[oldLinedefIndex[i]] = linedefs[i];
+        for (int i = 0; i < weld.linedefs.size(); i++)
+            newLinedefs[weld.linedefs[i]] = weld.linedefData[i];
+        linedefs.swap(newLinedefs);
+
+        for (int i = 0; i < weld.changed.size(); i++)
+            linedefs[weld.changed[i]] = weld.changedBefore[i];
+    }
+
+    if (weld.linedefs.size())
+        tagIndexDirty = true;
+    gridDirty = true;
+    markGeometryChanged();
+
+    // linedef numbers moved. this can't wait for updateDirtySectors, the weld might not have made any sector dirty.
+    updateAdjacency();
+
+    if (undo)
+        markWeldDirty(weld);
+}
+
+void DoomMap::record(int field, int index, qint32 before0, qint32 before1, qint32 after0, qint32 after1)
+{
+    if (journalPaused)
+        return;
+
+    DoomMapDelta delta;
+    delta.field = field;
+    delta.index = index;
+    delta.before[0] = before0;
+    delta.before[1] = before1;
+    delta.after[0] = after0;
+    delta.after[1] = after1;
+    journal->record(delta);
+}
+
+void DoomMap::beginAction(const QString& name)
+{
+    journal->beginAction(name);
+}
+
+void DoomMap::endAction()
+{
+    journal->endAction();
+
+    // the edit is complete, no need to wait for more
+    if (!journal->isInAction())
+        updateNodes(true);
+}
+
+bool DoomMap::canUndo() const
+{
+    return journal->canUndo();
+}
+
+bool DoomMap::canRedo() const
+{
+    return journal->canRedo();
+}
+
+void DoomMap::applyDelta(const DoomMapDelta& delta, bool undo)
+{
+    const qint32* v = undo ? delta.before : delta.after;
+    switch (delta.field)
+    {
+    case DoomMapDelta::VertexPosition:
+        setVertexPosition(delta.index, DoomMapDelta::toFloat(v[0]), DoomMapDelta::toFloat(v[1]));
+        break;
+    case DoomMapDelta::LinedefVertices:
+        setLinedefVertices(delta.index, v[0], v[1]);
+        break;
+    case DoomMapDelta::LinedefSidedefs:
+        setLinedefSidedefs(delta.index, v[0], v[1]);
+        break;
+    case DoomMapDelta::SidedefSector:
+        setSidedefSector(delta.index, v[0]);
+        break;
+    case DoomMapDelta::SidedefTexture:
+        setSidedefTexture(delta.index, v[1], v[0]);
+        break;
+    case DoomMapDelta::SectorTexture:
+        setSectorTexture(delta.index, v[1], v[0]);
+        break;
+    case DoomMapDelta::SectorTag:
+        setSectorTag(delta.index, v[0]);
+        break;
+    case DoomMapDelta::LinedefId:
+        setLinedefId(delta.index, v[0]);
+        break;
+    case DoomMapDelta::ThingId:
+        setThingId(delta.index, v[0]);
+        break;
+    }
+}
+
+bool DoomMap::undo()
+{
+    const DoomMapJournalAction* action = journal->takeUndo();
+    if (!action)
+        return false;
+
+    journalPaused = true;
+    if (action->weld >= 0)
+        applyWeld(journal->getWeld(action->weld), true);
+    for (int i = action->numDeltas-1; i >= 0; i--)
+        applyDelta(journal->getDelta(action->firstDelta+i), true);
+    journalPaused = false;
+    return true;
+}
+
+bool DoomMap::redo()
+{
+    const DoomMapJournalAction* action = journal->takeRedo();
+    if (!action)
+        return false;
+
+    journalPaused = true;
+    if (action->weld >= 0)
+        applyWeld(journal->getWeld(action->weld), false);
+    for (int i = 0; i < action->numDeltas; i++)
+        applyDelta(journal->getDelta(action->firstDelta+i), false);
+    journalPaused = false;
+    return true;
+}
+
+QVector<int> DoomMap::sectorsAt(const QVector<QPointF>& points) const
+{
+    QVector<int> out(points.size());
+
+    DoomMap_SectorsAtJob job;
+    job.map = this;
+    job.points = &points;
+    job.out = out.data();
+
+    // each chunk is a few thousands of lookups, otherwise threads don't pay off.
+    const int chunksize = 4096;
+    QVector<DoomMap_SectorsAtChunk> chunks;
+    for (int i = 0; i < points.size(); i += chunksize)
+    {
+        DoomMap_SectorsAtChunk chunk;
+        chunk.start = i;
+        chunk.end = qMin(i+chunksize, points.size());
+        chunks.append(chunk);
+    }
+
+    if (chunks.size() > 1)
+        QtConcurrent::blockingMap(chunks, job);
+    else if (chunks.size())
+        job(chunks[0]);
+
+    return out;
+}
+
+static int DetectMapsSorter(const void* a, const void* b)
+{
+    DetectedDoomMap* ma = (DetectedDoomMap*)a;
+    DetectedDoomMap* mb = (DetectedDoomMap*)b;
+    return ma->name.compare(mb->name);
+}
+
+QVector<DetectedDoomMap> DoomMap::detectMaps(WADFile* wad)
+{
+    QVector<DetectedDoomMap> maps;
+
+    int snum = 0;
+    while (true)
+    {
+        // find next THINGS lump or TEXTMAP lump.
+        int tnum = wad->getNumForName("THINGS", snum);
+        int unum = wad->getNumForName("TEXTMAP", snum);
+        int num = -1;
+        if (tnum < 0)
+            num = unum;
+        else if (unum < 0)
+            num = tnum;
+        else num = std::min(tnum, unum);
+
+        if (num < 0) // end of maps
+            break;
+
+        snum = num+1;
+
+        // check correct order of lumps if this is a text map
+        bool hasbehavior = false;
+        MapType type;
+        if (num == unum)
+        {
+            type = UDMF;
+            int endmap = wad->getNumForName("ENDMAP", snum);
+            if (endmap < 0)
+                continue; // invalid textmap
+            int behnum = wad->getNumForName("BEHAVIOR");
+            hasbehavior = behnum >= 0 && behnum < endmap;
+        }
+        else
+        {
+            bool validmap = true;
+            QStringList entriesOrder = QStringList() << "THINGS" << "LINEDEFS" << "SIDEDEFS" << "VERTEXES" << "SEGS" << "SSECTORS" << "NODES" << "SECTORS" << "REJECT" << "BLOCKMAP";
+            for (int i = 1; i < entriesOrder.size(); i++)
+            {
+                WADEntry* nextent = wad->getEntry(num+i);
+                if (nextent == 0 || (nextent->getName().toUpper() != entriesOrder[i]))
+                {
+                    validmap = false;
+                    break;
+                }
+            }
+
+            if (!validmap)
+                continue;
+
+            hasbehavior = wad->getEntry(num+entriesOrder.size()) && (wad->getEntry(num+entriesOrder.size())->getName().toUpper() == "BEHAVIOR");
+            if (hasbehavior)
+                type = Hexen;
+            else
+            {
+                // detect strife. or not.
+                type = Doom;
+            }
+        }
+
+        WADEntry* prevent = wad->getEntry(num-1);
+        if (prevent == 0)
+            continue; // :(
+
+        DetectedDoomMap ddm;
+        ddm.name = prevent->getName().toUpper();
+        ddm.type = type;
+        maps.append(ddm);
+    }
+
+    // sort maps by name
+    qsort(maps.data(), maps.size(), sizeof(DetectedDoomMap), &DetectMapsSorter);
+
+    return maps;
+}
+
+void DoomMap::initUDMF(QString text)
+{
+
+}
+
+void DoomMap::initClassic(QIODevice* things, QIODevice* linedefs, QIODevice* sidedefs, QIODevice* vertexes, QIODevice* sectors)
+{
+    // linedefs, sidedefs, sectors
+    // one vertex = 4 bytes
+    int numvertexes = vertexes->size() / 4;
+    vertices.reserve(numvertexes);
+    QDataStream vertexes_stream(vertexes);
+    vertexes_stream.setByteOrder(QDataStream::LittleEndian);
+    for (int i = 0; i < numvertexes; i++)
+    {
+        qint16 x;
+        qint16 y;
+        vertexes_stream >> x >> y;
+        DoomMapVertex vx;
+        vx.x = (float)x;
+        vx.y = (float)y;
+        vertices.append(vx);
+    }
+
+    // one linedef = 14 bytes for Doom, and 16 bytes for Hexen
+    int numlinedefs = (type == Hexen) ? linedefs->size() / 16 : linedefs->size() / 14;
+    this->linedefs.reserve(numlinedefs);
+    QDataStream linedefs_stream(linedefs);
+    linedefs_stream.setByteOrder(QDataStream::LittleEndian);
+    for (int i = 0; i < numlinedefs; i++)
+    {
+        if (type == Hexen)
+        {
+            quint16 v1;
+            quint16 v2;
+            quint16 flags;
+            quint8 special;
+            quint8 arg0;
+            quint8 arg1;
+            quint8 arg2;
+            quint8 arg3;
+            quint8 arg4;
+            quint16 sidefront;
+            quint16 sideback;
+            linedefs_stream >> v1 >> v2 >> flags >> special >> arg0 >> arg1 >> arg2 >> arg3 >> arg4 >> sidefront >> sideback;
+            DoomMapLinedef ln;
+            ln.v1 = (int)v1;
+            ln.v2 = (int)v2;
+            ln.special = (int)special;
+            ln.arg0 = (int)arg0;
+            ln.arg1 = (int)arg1;
+            ln.arg2 = (int)arg2;
+            ln.arg3 = (int)arg3;
+            ln.arg4 = (int)arg4;
+            ln.sidefront = (sidefront < 0xFFFF) ? (int)sidefront : -1;
+            ln.sideback = (sideback < 0xFFFF) ? (int)sideback : -1;
+            // todo parse flags
+            this->linedefs.append(ln);
+        }
+        else
+        {
+            quint16 v1;
+            quint16 v2;
+            quint16 flags;
+            quint16 special;
+            quint16 tag;
+            quint16 sidefront;
+            quint16 sideback;
+            linedefs_stream >> v1 >> v2 >> flags >> special >> tag >> sidefront >> sideback;
+            DoomMapLinedef ln;
+            ln.v1 = (int)v1;
+            ln.v2 = (int)v2;
+            ln.special = (int)special;
+            ln.id = (int)tag;
+            ln.sidefront = (sidefront < 0xFFFF) ? (int)sidefront : -1;
+            ln.sideback = (sideback < 0xFFFF) ? (int)sideback : -1;
+            if ((flags & 0x0001) == 0x0001)
+                ln.blocking = true;
+            if ((flags & 0x0002) == 0x0002)
+                ln.blockmonsters = true;
+            if ((flags & 0x0004) == 0x0004)
+                ln.twosided = true;
+            if ((flags & 0x0008) == 0x0008)
+                ln.dontpegtop = true;
+            if ((flags & 0x0010) == 0x0010)
+                ln.dontpegbottom = true;
+            if ((flags & 0x0020) == 0x0020)
+                ln.secret = true;
+            if ((flags & 0x0040) == 0x0040)
+                ln.blocksound = true;
+            if ((flags & 0x0080) == 0x0080)
+                ln.dontdraw = true;
+            if ((flags & 0x0100) == 0x0100)
+                ln.mapped = true;
+            // todo parse zdoom/boom/strife flags
+            this->linedefs.append(ln);
+        }
+    }
+
+    // one sidedef = 30 bytes
+    int numsidedefs = sidedefs->size() / 30;
+    this->sidedefs.reserve(numsidedefs);
+    QDataStream sidedefs_stream(sidedefs);
+    sidedefs_stream.setByteOrder(QDataStream::LittleEndian);
+    for (int i = 0; i < numsidedefs; i++)
+    {
+        qint16 offsetx;
+        qint16 offsety;
+        char rtexturetop[9] = {0};
+        char rtexturebottom[9] = {0};
+        char rtexturemiddle[9] = {0};
+        quint16 sector;
+        sidedefs_stream >> offsetx >> offsety;
+        sidedefs_stream.readRawData(rtexturetop, 8);
+        sidedefs_stream.readRawData(rtexturebottom, 8);
+        sidedefs_stream.readRawData(rtexturemiddle, 8);
+        sidedefs_stream >> sector;
+        DoomMapSidedef sd;
+        sd.offsetx = (float)offsetx;
+        sd.offsety = (float)offsety;
+        sd.texturetop = Tex_GetTextureId(QString::fromUtf8(rtexturetop));
+        sd.texturebottom = Tex_GetTextureId(QString::fromUtf8(rtexturebottom));
+        sd.texturemiddle = Tex_GetTextureId(QString::fromUtf8(rtexturemiddle));
+        sd.sector = (int)sector;
+        this->sidedefs.append(sd);
+    }
+
+    // one sector = 26 bytes
+    int numsectors = sectors->size() / 26;
+    this->sectors.reserve(numsectors);
+    QDataStream sectors_stream(sectors);
+    sectors_stream.setByteOrder(QDataStream::LittleEndian);
+    for (int i = 0; i < numsectors; i++)
+    {
+        qint16 heightfloor;
+        qint16 heightceiling;
+        char texturefloor[9] = {0};
+        char textureceiling[9] = {0};
+        qint16 lightlevel;
+        quint16 special;
+        quint16 tag;
+        sectors_stream >> heightfloor >> heightceiling;
+        sectors_stream.readRawData(texturefloor, 8);
+        sectors_stream.readRawData(textureceiling, 8);
+        sectors_stream >> lightlevel >> special >> tag;
+        DoomMapSector sec;
+        sec.heightfloor = (float)heightfloor;
+        sec.heightceiling = (float)heightceiling;
+        sec.texturefloor = Tex_GetTextureId(QString::fromUtf8(texturefloor));
+        sec.textureceiling = Tex_GetTextureId(QString::fromUtf8(textureceiling));
+        sec.lightlevel = (int)lightlevel;
+        sec.special = (int)special;
+        sec.id = (int)tag;
+        this->sectors.append(sec);
+    }
+
+    // one thing = 10 bytes for Doom, and 20 bytes for Hexen
+    int numthings = (type == Hexen) ? things->size() / 20 : things->size() / 10;
+    QDataStream things_stream(things);
+    things_stream.setByteOrder(QDataStream::LittleEndian);
+    this->things.clear();
+    this->things.reserve(numthings);
+    for (int i = 0; i < numthings; i++)
+    {
+        if (type == Hexen)
+        {
+            qint16 tid;
+            qint16 x;
+            qint16 y;
+            qint16 height;
+            qint16 angle;
+            qint16 ttype;
+            quint16 flags;
+            quint8 special;
+            quint8 args[5];
+            things_stream >> tid >> x >> y >> height >> angle >> ttype >> flags >> special;
+            for (int j = 0; j < 5; j++)
+                things_stream >> args[j];
+            int th = this->things.append((float)x, (float)y, (float)height, angle, ttype, flags);
+            this->things.id[th] = (int)tid;
+            this->things.special[th] = special;
+            for (int j = 0; j < 5; j++)
+                this->things.setArg(th, j, args[j]);
+        }
+        else
+        {
+            qint16 x;
+            qint16 y;
+            qint16 angle;
+            qint16 ttype;
+            quint16 flags;
+            things_stream >> x >> y >> angle >> ttype >> flags;
+            this->things.append((float)x, (float)y, 0, angle, ttype, flags);
+        }
+    }
+}
+
+void DoomMap::unpackSidedefs()
+{
+    // unpack sidedefs, also remove invalid sidedefs.
+    for (int i = 0; i < this->linedefs.size(); i++)
+    {
+        if (this->linedefs[i].sidefront >= this->sidedefs.size())
+            this->linedefs[i].sidefront = -1;
+        if (this->linedefs[i].sideback >= this->sidedefs.size())
+            this->linedefs[i].sideback = -1;
+    }
+
+    for (int i = 0; i < this->linedefs.size(); i++)
+    {
+        int vfront = this->linedefs[i].sidefront;
+        int vback = this->linedefs[i].sideback;
+
+        for (int j = 0; j < this->linedefs.size(); j++)
+        {
+            if (i == j)
+                continue;
+
+            int cfront = this->linedefs[j].sidefront;
+            int cback = this->linedefs[j].sideback;
+
+            if (cfront >= 0 && (cfront == vfront || cfront == vback))
+            {
+                DoomMapSidedef side = this->sidedefs[cfront];
+                this->sidedefs.append(side);
+                this->linedefs[j].sidefront = this->sidedefs.size()-1;
+            }
+
+            if (cback >= 0 && (cback == vfront || cback == vback))
+            {
+                DoomMapSidedef side = this->sidedefs[cback];
+                this->sidedefs.append(side);
+                this->linedefs[j].sideback = this->sidedefs.size()-1;
+            }
+        }
+    }
+}
+
+void DoomMap::initReject(QByteArray& data)
+{
+    // REJECT is a bit matrix of sectors*sectors bits, row is the source sector.
+    // node builders often write it zero-filled or truncated; zero-filled is valid but rejects nothing.
+    reject.clear();
+    rejectSize = sectors.size();
+
+    qint64 bits = (qint64)rejectSize * rejectSize;
+    if (!rejectSize || data.size() < (bits + 7) / 8)
+    {
+        rejectSize = 0;
+        return;
+    }
+
+    // don't keep the table if it's all zeroes
+    const char* raw = data.constData();
+    int len = (bits + 7) / 8;
+    for (int i = 0; i < len; i++)
+    {
+        if (raw[i])
+        {
+            reject = data.left(len);
+            return;
+        }
+    }
+
+    rejectSize = 0;
+}
+
+static double DoomMapSectorArea(const QPolygonF& p)
+{
+    double at = 0;
+    for (int i = 0; i < p.size(); i++)
+    {
+        const QPointF& p1 = p[i];
+        const QPointF& p2 = p[(i+1)%p.size()];
+        double ac = (p1.x()*p2.y()) - (p2.x()*p1.y());
+        at += ac;
+    }
+
+    at /= 2;
+    if (at < 0) at = -at;
+    return at;
+}
+
+// 1 if inside, -1 if outside, 0 if on the boundary
+static int DoomMapSector_PointInPolygon(const QPointF& pt, const QPolygonF& poly)
+{
+    bool inside = false;
+    double x = pt.x();
+    double y = pt.y();
+    for (int i = 0, j = poly.size()-1; i < poly.size(); j = i++)
+    {
+        double x1 = poly[j].x();
+        double y1 = poly[j].y();
+        double x2 = poly[i].x();
+        double y2 = poly[i].y();
+
+        // on this edge?
+        double cross = (x2 - x1) * (y - y1) - (y2 - y1) * (x - x1);
+        if (cross == 0 && x >= qMin(x1, x2) && x <= qMax(x1, x2) && y >= qMin(y1, y2) && y <= qMax(y1, y2))
+            return 0;
+
+        if ((y1 > y) != (y2 > y))
+        {
+            // crossing is right of the point if cross has the same sign as the edge direction
+            if ((cross > 0) == (y2 > y1))
+                inside = !inside;
+        }
+    }
+
+    return inside ? 1 : -1;
+}
+
+// loops of one sector don't cross, so one point that is not on the boundary decides.
+static bool DoomMapSector_PolygonInside(const QPolygonF& inner, const QPolygonF& outer)
+{
+    for (int i = 0; i < inner.size(); i++)
+    {
+        int r = DoomMapSector_PointInPolygon(inner[i], outer);
+        if (r) return (r > 0);
+    }
+
+    // every vertex touches, try middles of edges
+    for (int i = 0; i < inner.size(); i++)
+    {
+        const QPointF& p1 = inner[i];
+        const QPointF& p2 = inner[(i+1)%inner.size()];
+        int r = DoomMapSector_PointInPolygon(QPointF((p1.x()+p2.x())/2, (p1.y()+p2.y())/2), outer);
+        if (r) return (r > 0);
+    }
+
+    return false;
+}
+
+struct DoomMapSector_Loop
+{
+    DoomMapSector_Loop()
+    {
+        index = -1;
+        area = 0;
+        parent = -1;
+        depth = 0;
+    }
+
+    int index; // in polygons
+    double area;
+    QRectF bounds;
+    int parent; // in loops
+    int depth;
+};
+
+struct DoomMapSector_LoopLess
+{
+    bool operator()(const DoomMapSector_Loop& a, const DoomMapSector_Loop& b) const
+    {
+        if (a.area != b.area)
+            return a.area > b.area;
+        return a.index < b.index;
+    }
+};
+
+quint64 SectorPolygonTracer::positionKey(float x, float y)
+{
+    // vertices are the same if they are the same in fixed point, so this agrees with the angle tests below.
+    FixedPoint p = Geometry::toFixed(x, y);
+    return ((quint64)(quint32)p.x << 32) | (quint32)p.y;
+}
+
+void SectorPolygonTracer::buildOutgoing()
+{
+    checkedlinedefs.fill(false, linedefs.size());
+    nextoutgoing.fill(-1, linedefs.size());
+    outgoing.clear();
+    outgoing.reserve(linedefs.size());
+
+    // walk backwards, so that every list ends up in linedef order.
+    for (int i = linedefs.size()-1; i >= 0; i--)
+    {
+        const DoomMapVertex* v1 = linedefs[i]->getV1(map, sector);
+        const DoomMapVertex* v2 = linedefs[i]->getV2(map, sector);
+        if (!v1 || !v2)
+        {
+            // broken line, never trace it.
+            checkedlinedefs.setBit(i);
+            continue;
+        }
+
+        quint64 key = positionKey(v1->x, v1->y);
+        nextoutgoing[i] = outgoing.value(key, -1);
+        outgoing[key] = i;
+    }
+}
+
+QPair< QPolygonF, QVector<int> > SectorPolygonTracer::nextPolygon(int line)
+{
+    const DoomMapLinedef* startld = linedefs[line];
+    const DoomMapVertex* vs = startld->getV1(map, sector); // this is the vertex that we start from
+    quint64 startkey = positionKey(vs->x, vs->y);
+
+    QVector< QPair< QPolygonF, QVector<int> > > results;
+
+    // lines of the polygon being traced
+    QBitArray polybits(linedefs.size());
+    QVector<int> outcomes;
+
+    bool log = false;//(sector == 0);
+
+    // scan twice, first with choosing larger angle, second with choosing smaller angle.
+    for (int k = 0; k < 2; k++)
+    {
+        if (log) qDebug("sector %d, pass %d", sector, k);
+        if (log) qDebug("sector %d, line = %d", sector, startld-map->linedefs.constData());
+
+        const DoomMapVertex* vp = startld->getV2(map, sector); // this is the next vertex to find
+
+        QPolygonF poly;
+        QVector<int> polylines;
+
+        poly.append(QPointF(vs->x, vs->y));
+        polylines.append(line);
+        polybits.fill(false);
+        polybits.setBit(line);
+
+        int prevld = line;
+
+        while (true)
+        {
+            quint64 key = positionKey(vp->x, vp->y);
+            if (key == startkey)
+            {
+                // successful trace, add polygon
+                if (log) qDebug("sector %d, pass closed", sector);
+                break;
+            }
+
+            // lines that start at this vertex and weren't checked already.
+            outcomes.clear();
+            for (int i = outgoing.value(key, -1); i >= 0; i = nextoutgoing[i])
+            {
+                if (!checkedlinedefs.testBit(i) && !polybits.testBit(i))
+                    outcomes.append(i);
+            }
+
+            if (!outcomes.size())
+            {
+                // no next vertex found. invalid polygon.
+                poly.clear();
+                polylines.clear();
+                if (log) qDebug("sector %d, pass NOT closed", sector);
+                break;
+            }
+
+            int nextld = outcomes[0];
+            if (outcomes.size() > 1)
+            {
+                // here we have multiple possible outcomes. pick by counterclockwise angle from the previous line, seen from this vertex.
+                const DoomMapVertex* pv1 = linedefs[prevld]->getV1(map, sector);
+                FixedPoint origin = Geometry::toFixed(vp->x, vp->y);
+                FixedPoint back = Geometry::toFixed(pv1->x, pv1->y) - origin;
+                FixedPoint best = Geometry::toFixed(linedefs[nextld]->getV2(map, sector)->x, linedefs[nextld]->getV2(map, sector)->y) - origin;
+
+                for (int j = 1; j < outcomes.size(); j++)
+                {
+                    const DoomMapVertex* cV2 = linedefs[outcomes[j]]->getV2(map, sector);
+                    FixedPoint dir = Geometry::toFixed(cV2->x, cV2->y) - origin;
+                    if (log) qDebug("sector %d, possible line = %d", sector, linedefs[outcomes[j]]-map->linedefs.constData());
+                    if ((k == 0 && Geometry::angleLess(back, dir, best)) ||
+                        (k == 1 && Geometry::angleLess(back, best, dir)))
+                    {
+                        nextld = outcomes[j];
+                        best = dir;
+                    }
+                }
+            }
+
+            poly.append(QPointF(vp->x, vp->y));
+            polylines.append(nextld);
+            polybits.setBit(nextld);
+            prevld = nextld;
+            vp = linedefs[nextld]->getV2(map, sector);
+            if (log) qDebug("sector %d, line = %d", sector, linedefs[nextld]-map->linedefs.constData());
+        }
+
+        if (poly.size())
+            results.append(QPair< QPolygonF, QVector<int> > (poly, polylines));
+    }
+
+    // if there are no results, this empty pair is returned. it's okay and expected.
+    double refArea = 4294967296;
+    QPair< QPolygonF, QVector<int> > refResult;
+    for (int i = 0; i < results.size(); i++)
+    {
+        double cArea = DoomMapSectorArea(results[i].first);
+        if (cArea < refArea)
+        {
+            refResult = results[i];
+            refArea = cArea;
+        }
+    }
+
+    if (log) qDebug("sector %d, result has %d vertices", sector, refResult.first.size());
+
+    return refResult;
+}
+
+void DoomMapSector::triangulate(DoomMap* map)
+{
+    DoomMapSectorTriangles result;
+    computeTriangles(map, map->getIntersections(), result);
+    applyTriangles(map, result);
+}
+
+// per thread triangulation state. the triangulator buffers are reused between sectors.
+struct DoomMapSector_Scratch
+{
+    Triangulator triangulator;
+};
+
+static QThreadStorage<DoomMapSector_Scratch*> DoomMapSector_Scratches;
+
+void DoomMapSector::computeTriangles(const DoomMap* map, const DoomMapIntersections& intersections, DoomMapSectorTriangles& out) const
+{
+    // resize(0) keeps the allocated memory, if a result is reused
+    out.triangles.resize(0);
+    out.vertices.resize(0);
+
+    if (!DoomMapSector_Scratches.hasLocalData())
+        DoomMapSector_Scratches.setLocalData(new DoomMapSector_Scratch());
+    DoomMapSector_Scratch* scratch = DoomMapSector_Scratches.localData();
+
+    // first, split the sector into line loops (polygons)
+    int index = getIndex(map);
+    SectorPolygonTracer spt(map, index);
+
+    QVector<const DoomMapLinedef*> linedefs = spt.getAllLinedefs();
+    QVector<int>& vertices = out.vertices;
+    for (int i = 0; i < linedefs.size(); i++)
+    {
+        int v[2] = { linedefs[i]->v1, linedefs[i]->v2 };
+        for (int j = 0; j < 2; j++)
+        {
+            if (v[j] >= 0 && v[j] < map->vertices.size())
+                vertices.append(v[j]);
+        }
+    }
+
+    std::sort(vertices.begin(), vertices.end());
+    vertices.resize(std::unique(vertices.begin(), vertices.end()) - vertices.begin());
+
+    // lines crossing each other don't make polygons. don't make garbage triangles out of them, leave the sector empty until it's fixed.
+    if (intersections.isSectorBroken(index))
+    {
+        qDebug("DoomMapSector: sector %d has crossing lines, not triangulated", index);
+        return;
+    }
+
+    // go through linedefs in clockwise order and split the sector into separate shapes.
+    QVector<QPolygonF> polygons = spt.getPolygons();
+
+    if (polygons.size() < 1)
+        return;
+
+    // one triangulator per thread, so its buffers are reused between sectors.
+    Triangulator* triangulator = &scratch->triangulator;
+
+    // remove too small poly
+    for (int i = 0; i < polygons.size(); i++)
+    {
+        if (polygons[i].size() < 3)
+        {
+            polygons.removeAt(i);
+            i--;
+        }
+    }
+
+    // sort by area, largest first. a loop can only be inside of a larger one.
+    QVector<DoomMapSector_Loop> loops(polygons.size());
+    for (int i = 0; i < polygons.size(); i++)
+    {
+        loops[i].index = i;
+        loops[i].area = DoomMapSectorArea(polygons[i]);
+        loops[i].bounds = polygons[i].boundingRect();
+    }
+
+    std::sort(loops.begin(), loops.end(), DoomMapSector_LoopLess());
+
+    // build containment tree. parent of a loop is the smallest loop that contains it, which is the nearest one before it that does.
+    // even depth means the loop is an outer boundary, odd depth means it's a hole in its parent.
+    QVector< QList<QPolygonF> > holes(loops.size());
+    for (int i = 0; i < loops.size(); i++)
+    {
+        const QPolygonF& poly = polygons[loops[i].index];
+        for (int j = i-1; j >= 0; j--)
+        {
+            if (!loops[j].bounds.contains(loops[i].bounds))
+                continue;
+            if (!DoomMapSector_PolygonInside(poly, polygons[loops[j].index]))
+                continue;
+
+            loops[i].parent = j;
+            loops[i].depth = loops[j].depth+1;
+            break;
+        }
+
+        if (loops[i].depth & 1)
+            holes[loops[i].parent].append(poly);
+    }
+
+    for (int i = 0; i < loops.size(); i++)
+    {
+        if (loops[i].depth & 1)
+            continue;
+
+        const QPolygonF& poly = polygons[loops[i].index];
+        if (!triangulator->triangulate(poly, holes[i]))
+            qDebug("DoomMapSector: sector %d was not fully triangulated", index);
+
+        // make GL array now
+        const QVector<int>& tri_indices = triangulator->indices();
+        const QVector<QPointF>& tri_points = triangulator->points();
+        for (int j = 0; j < tri_indices.size(); j++)
+        {
+            GLVertex v;
+            v.x = tri_points[tri_indices[j]].x();
+            v.y = -tri_points[tri_indices[j]].y();
+            v.z = 0;
+            v.r = v.g = v.b = 255;
+            v.a = 64;
+            v.u = v.v = 0; // todo: set texture coordinates based on 64 grid
+            out.triangles.append(v);
+        }
+    }
+}
+
+void DoomMapSector::applyTriangles(DoomMap* map, DoomMapSectorTriangles& in)
+{
+    // old data stays in the arena until it's compacted
+    map->arenaWaste += triangles.size()*sizeof(GLVertex) + vertices.size()*sizeof(int);
+    triangles = map->arena.copy(in.triangles);
+    vertices = map->arena.copy(in.vertices);
+    updateBoundingBox(map);
+
+    int numlinedefs = getLinedefCount(map);
+    for (int i = 0; i < numlinedefs; i++)
+    {
+        DoomMapLinedef* linedef = getLinedef(map, i);
+        DoomMapSidedef* sidefront = linedef->getFront(map);
+        DoomMapSidedef* sideback = linedef->getBack(map);
+        if (sidefront) sidefront->glupdate = true;
+        if (sideback) sideback->glupdate = true;
+    }
+
+    glupdate = true;
+}
@@ -1,430 +1,736 @@
-#ifndef DOOMMAP_H
-#define DOOMMAP_H
-
-#include <QObject>
-#include <QVector>
-#include <QIODevice>
-#include "wadfile.h"
-#include <QMap>
-#include <QVariant>
-#include "../glarray.h"
-#include <QPolygonF>
-#include <QLineF>
-
-// map formats
-// 1) Doom
-// 2) Strife
-// 3) Hexen
-// 4) UDMF
-
-struct DetectedDoomMap;
-class DoomMapVertex;
-class DoomMapLinedef;
-class DoomMapSidedef;
-class DoomMapSector;
-class DoomMap : public QObject
-{
-    Q_OBJECT
-
-public:
-    enum MapType
-    {
-        Doom,
-        Strife,
-        Hexen,
-        UDMF
-    };
-
-    Q_ENUM(MapType)
-
-    DoomMap();
-    DoomMap(WADFile* wad, QString name);
-
-    //
-    static QVector<DetectedDoomMap> detectMaps(WADFile* wad);
-
-    // map fields!
-    QVector<DoomMapVertex> vertices;
-    QVector<DoomMapLinedef> linedefs;
-    QVector<DoomMapSidedef> sidedefs;
-    QVector<DoomMapSector> sectors;
-
-private:
-    MapType type;
-
-    QByteArray behavior;
-    QString scripts;
-
-    void initUDMF(QString text);
-    void initClassic(QIODevice* things, QIODevice* linedefs, QIODevice* sidedefs, QIODevice* vertexes, QIODevice* sectors);
-};
-
-struct DetectedDoomMap
-{
-    QString name;
-    DoomMap::MapType type;
-};
-
-// https://github.com/rheit/zdoom/blob/master/specs/udmf.txt
-class DoomMapComponent
-{
-public:
-    DoomMapComponent(DoomMap* parent)
-    {
-        this->parent = parent;
-        properties["comment"] = "";
-    }
-
-    DoomMap* getParent() { return parent; }
-    QMap<QString, QVariant>& getProperties() { return properties; }
-
-private:
-    DoomMap* parent;
-    QMap<QString, QVariant> properties;
-};
-
-class DoomMapVertex : public DoomMapComponent
-{
-public:
-    float x;
-    float y;
-
-    DoomMapVertex() : DoomMapComponent(0) {}
-    DoomMapVertex(DoomMap* parent) : DoomMapComponent(parent)
-    {
-        x = 0;
-        y = 0;
-    }
-};
-
-class DoomMapSidedef : public DoomMapComponent
-{
-public:
-    int offsetx;
-    int offsety;
-
-    QString texturetop;
-    QString texturebottom;
-    QString texturemiddle;
-
-    int sector;
-
-    // these are vertices for top, bottom and middle parts of this sidedef.
-    GLArray gltop;
-    GLArray glbottom;
-    GLArray glmiddle;
-    bool glupdate;
-
-    DoomMapSidedef() : DoomMapComponent(0) {}
-    DoomMapSidedef(DoomMap* parent) : DoomMapComponent(parent)
-    {
-        offsetx = offsety = 0;
-        texturetop = texturebottom = texturemiddle = "-";
-        sector = -1;
-        glupdate = false;
-    }
-
-    DoomMapSector* getSector()
-    {
-        if (sector < 0 || sector >= getParent()->sectors.size())
-            return 0;
-        return &getParent()->sectors[sector];
-    }
-};
-
-class DoomMapLinedef : public DoomMapComponent
-{
-public:
-    int id;
-    int v1;
-    int v2;
-
-    bool blocking;
-    bool blockmonsters;
-    bool twosided;
-    bool dontpegtop;
-    bool dontpegbottom;
-    bool secret;
-    bool blocksound;
-    bool dontdraw;
-    bool mapped;
-
-    bool passuse;
-
-    bool translucent;
-    bool jumpover;
-    bool blockfloaters;
-
-    bool playercross;
-    bool playeruse;
-    bool monstercross;
-    bool monsteruse;
-    bool impact;
-    bool playerpush;
-    bool monsterpush;
-    bool missilecross;
-    bool repeatspecial;
-
-    int special;
-    int arg0;
-    int arg1;
-    int arg2;
-    int arg3;
-    int arg4;
-
-    int sidefront;
-    int sideback;
-
-    DoomMapLinedef() : DoomMapComponent(0) {}
-    DoomMapLinedef(DoomMap* parent) : DoomMapComponent(parent)
-    {
-        id = 0;
-        v1 = -1;
-        v2 = -1;
-
-        blocking = false;
-        blockmonsters = false;
-        twosided = false;
-        dontpegtop = false;
-        dontpegbottom = false;
-        secret = false;
-        blocksound = false;
-        dontdraw = false;
-        mapped = false;
-
-        passuse = false;
-
-        translucent = false;
-        jumpover = false;
-        blockfloaters = false;
-
-        playercross = false;
-        playeruse = false;
-        monstercross = false;
-        monsteruse = false;
-        impact = false;
-        playerpush = false;
-        monsterpush = false;
-        missilecross = false;
-        repeatspecial = false;
-
-        special = 0;
-        arg0 = arg1 = arg2 = arg3 = arg4 = 0;
-
-        sidefront = sideback = -1;
-    }
-
-    DoomMapVertex* getV1(DoomMapSector* sector = 0)
-    {
-        if (sector && getFront() && getFront()->getSector() != sector)
-            return getV2();
-        if (v1 < 0 || v1 >= getParent()->vertices.size())
-            return 0;
-        return &getParent()->vertices[v1];
-    }
-
-    DoomMapVertex* getV2(DoomMapSector* sector = 0)
-    {
-        if (sector && getFront() && getFront()->getSector() != sector)
-            return getV1();
-        if (v2 < 0 || v2 >= getParent()->vertices.size())
-            return 0;
-        return &getParent()->vertices[v2];
-    }
-
-    DoomMapSidedef* getSidedef(DoomMapSector* sector)
-    {
-        DoomMapSidedef* front = getFront();
-        DoomMapSidedef* back = getBack();
-        DoomMapSector* frontSector = front ? front->getSector() : 0;
-        DoomMapSector* backSector = back ? back->getSector() : 0;
-        if (frontSector == sector) return front;
-        else if (backSector == sector) return back;
-        return 0;
-    }
-
-    DoomMapSidedef* getFront()
-    {
-        if (sidefront < 0 || sidefront >= getParent()->sidedefs.size())
-            return 0;
-        return &getParent()->sidedefs[sidefront];
-    }
-
-    DoomMapSidedef* getBack()
-    {
-        if (sideback < 0 || sideback >= getParent()->sidedefs.size())
-            return 0;
-        return &getParent()->sidedefs[sideback];
-    }
-};
-
-class DoomMapSector : public DoomMapComponent
-{
-public:
-    int heightfloor;
-    int heightceiling;
-
-    QString texturefloor;
-    QString textureceiling;
-
-    int lightlevel;
-
-    int special;
-    int id;
-
-    DoomMapSector() : DoomMapComponent(0) {}
-    DoomMapSector(DoomMap* parent) : DoomMapComponent(parent)
-    {
-        heightfloor = heightceiling = 0;
-        texturefloor = textureceiling = "-";
-        lightlevel = 160;
-        special = id = 0;
-        glupdate = false;
-    }
-
-    // generate sector triangles
-    void triangulate();
-
-    GLArray triangles; // this is by default at height 0, to be used with glTranslate if needed for floor/ceiling. edit: its better to use separate versions of this array for f/c, for slopes
-    QVector<DoomMapVertex*> vertices; // all vertices of sector.
-    QVector<DoomMapLinedef*> linedefs; // all linedefs of sector.
-    QRectF boundingBox; // bounding box of sector.
-
-    // opengl
-    GLArray glfloor;
-    GLArray glceiling;
-    bool glupdate;
-
-    void updateBoundingBox()
-    {
-        float xMin = 65536;
-        float xMax = -65536;
-        float yMin = 65536;
-        float yMax = -65536;
-
-        for (int i = 0; i < vertices.size(); i++)
-        {
-            float x = vertices[i]->x;
-            float y = vertices[i]->y;
-            if (x < xMin) xMin = x;
-            if (x > xMax) xMax = x;
-            if (y < yMin) yMin = y;
-            if (y > yMax) yMax = y;
-        }
-
-        boundingBox = QRectF(xMin, yMin, xMax-xMin, yMax-yMin);
-    }
-
-    bool isAnyWithin(float x, float y, float dst)
-    {
-        //
-        // check bounding box within
-        if (!boundingBox.adjusted(-dst, -dst, +dst, +dst).contains(x, y))
-            return false;
-
-        for (int i = 0; i < vertices.size(); i++)
-        {
-            if (QLineF(vertices[i]->x, vertices[i]->y, x, y).length() <= dst)
-                return true;
-        }
-
-        return false;
-    }
-
-    // todo slope calculations
-    float zatFloor(float x, float y)
-    {
-        return heightfloor;
-    }
-
-    float zatCeiling(float x, float y)
-    {
-        return heightceiling;
-    }
-};
-
-class SectorPolygonTracer
-{
-public:
-    SectorPolygonTracer(DoomMapSector* sector)
-    {
-        this->sector = sector;
-        linedefs.clear();
-
-        DoomMap* p = sector->getParent();
-        for (int i = 0; i < p->linedefs.size(); i++)
-        {
-            DoomMapSidedef* front = p->linedefs[i].getFront();
-            DoomMapSidedef* back = p->linedefs[i].getBack();
-
-            bool hfront = (front && front->getSector() == sector);
-            bool hback = (back && back->getSector() == sector);
-
-            if (hfront || hback)
-            {
-                alllinedefs.append(&p->linedefs[i]);
-                if (!hfront || !hback)
-                    linedefs.append(&p->linedefs[i]);
-            }
-        }
-    }
-
-    // returns linedefs that refer to this sector with one of their sidedefs
-    QVector<DoomMapLinedef*> getLinedefs()
-    {
-        return linedefs;
-    }
-
-    QVector<DoomMapLinedef*> getAllLinedefs()
-    {
-        return alllinedefs;
-    }
-
-    // returns a list of separate line loops in this sector.
-    QVector<QPolygonF> getPolygons()
-    {
-        QVector<QPolygonF> polygons;
-        while (true)
-        {
-            // find first unchecked line.
-            DoomMapLinedef* nextld = 0;
-            for (int i = 0; i < linedefs.size(); i++)
-            {
-                if (checkedlinedefs.contains(linedefs[i]))
-                    continue;
-                nextld = linedefs[i];
-                break;
-            }
-
-            if (!nextld)
-                break;
-
-            QPair< QPolygonF, QVector<DoomMapLinedef*> > poly = nextPolygon(nextld);
-            if (poly.first.size() <= 0)
-                break;
-            polygons.append(poly.first);
-            for (int i = 0; i < poly.second.size(); i++)
-                checkedlinedefs.append(poly.second[i]);
-        }
-
-        return polygons;
-    }
-
-private:
-
-    DoomMapSector* sector;
-
-    // a list of linedefs in the reference sector.
-    QVector<DoomMapLinedef*> alllinedefs; // including self referencing
-    QVector<DoomMapLinedef*> linedefs;
-
-    // a list of linedefs that have already been traversed.
-    QVector<DoomMapLinedef*> checkedlinedefs;
-
-    // returns a pair of polygon and lines that this polygon consists of.
-    // if no polygon found, returns two empty objects.
-    // currentcheckedlinedefs is used to prevent infinite recursion.
-    QPair< QPolygonF, QVector<DoomMapLinedef*> > nextPolygon(DoomMapLinedef* line);
-};
-
-#endif // DOOMMAP_H
+#ifndef DOOMMAP_H
+#define DOOMMAP_H
+
+#include <QObject>
+#include <QVector>
+#include <QIODevice>
+#include "wadfile.h"
+#include "doommapnodes.h"
+#include "doommaptopology.h"
+#include "doommapintersections.h"
+#include "doommapproperties.h"
+#include "doommaparena.h"
+#include "doommaptextureindex.h"
+#include "doommaptagindex.h"
+#include "doommapgrid.h"
+#include "texman.h"
+#include "../glarray.h"
+#include <QPolygonF>
+#include <QLineF>
+#include <QHash>
+#include <QBitArray>
+#include <QElapsedTimer>
+
+// map formats
+// 1) Doom
+// 2) Strife
+// 3) Hexen
+// 4) UDMF
+
+// things are stored as a structure of arrays instead of separate components.
+// there can be tens of thousands of them, and renderers only need positions and types most of the time.
+class DoomMapThings
+{
+public:
+    QVector<float> x;
+    QVector<float> y;
+    QVector<float> z; // height relative to the floor
+    QVector<qint16> angle;
+    QVector<qint16> type;
+    QVector<quint16> flags;
+    QVector<int> id; // tid in hexen
+    QVector<quint8> special;
+    QVector<quint8> args; // 5 per thing
+
+    int size() const { return type.size(); }
+
+    void clear()
+    {
+        x.clear();
+        y.clear();
+        z.clear();
+        angle.clear();
+        type.clear();
+        flags.clear();
+        id.clear();
+        special.clear();
+        args.clear();
+    }
+
+    void reserve(int count)
+    {
+        x.reserve(count);
+        y.reserve(count);
+        z.reserve(count);
+        angle.reserve(count);
+        type.reserve(count);
+        flags.reserve(count);
+        id.reserve(count);
+        special.reserve(count);
+        args.reserve(count*5);
+    }
+
+    // returns index of the new thing
+    int append(float x, float y, float z, int angle, int type, int flags)
+    {
+        this->x.append(x);
+        this->y.append(y);
+        this->z.append(z);
+        this->angle.append(angle);
+        this->type.append(type);
+        this->flags.append(flags);
+        this->id.append(0);
+        this->special.append(0);
+        for (int i = 0; i < 5; i++)
+            this->args.append(0);
+        return this->type.size()-1;
+    }
+
+    quint8 getArg(int thing, int arg) const { return args[thing*5+arg]; }
+    void setArg(int thing, int arg, quint8 value) { args[thing*5+arg] = value; }
+
+    // radius and height of a thing type, for doom 2 types. anything else gets the size of a pickup.
+    static void getTypeSize(int type, float& radius, float& height);
+};
+
+struct DetectedDoomMap;
+struct DoomMapDelta;
+struct DoomMapWeldResult;
+struct DoomMapWeld;
+class DoomMapJournal;
+class DoomMapVertex;
+class DoomMapLinedef;
+class DoomMapSidedef;
+class DoomMapSector;
+class DoomMap : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum MapType
+    {
+        Doom,
+        Strife,
+        Hexen,
+        UDMF
+    };
+
+    Q_ENUM(MapType)
+
+    DoomMap();
+    DoomMap(WADFile* wad, QString name);
+    ~DoomMap();
+
+    //
+    static QVector<DetectedDoomMap> detectMaps(WADFile* wad);
+
+    // map fields!
+    QVector<DoomMapVertex> vertices;
+    QVector<DoomMapLinedef> linedefs;
+    QVector<DoomMapSidedef> sidedefs;
+    QVector<DoomMapSector> sectors;
+    DoomMapThings things;
+    // extra fields of all components above (comments, UDMF fields that don't have their own member)
+    DoomMapProperties properties;
+
+    // bsp tree. loaded from vanilla-format nodes, or built if the map has none.
+    DoomMapNodes nodes;
+    // rebuilds nodes from current geometry. returns false if the map has no lines.
+    bool buildNodes();
+    // rebuilds nodes if geometry was edited since they were built. unless force is set, this waits until geometry wasn't edited for a moment,
+    // so dragging vertices doesn't build nodes every frame. updateDirtySectors() and the end of an action call this.
+    // returns true if nodes were built.
+    bool updateNodes(bool force);
+
+    // returns sector at x/y (map coordinates), or -1 if unknown. this walks the bsp tree, so it's O(log n).
+    // like in the game, the result is the sector of the subsector whose bsp region has the point, so points in the void still get a sector.
+    // after a geometry edit nodes are invalid and this returns -1, until updateNodes() builds them at the end of the action,
+    // or once geometry wasn't edited for a moment.
+    int sectorAt(float x, float y) const;
+    // same for lots of points at once. large batches are split between threads.
+    QVector<int> sectorsAt(const QVector<QPointF>& points) const;
+
+    // sector-to-sector visibility from the REJECT lump.
+    // returns true if sector "to" can't be seen from sector "from". without valid REJECT, nothing is rejected.
+    // REJECT only fits the geometry it was made for, so it's dropped by the first geometry edit.
+    bool isRejected(int from, int to) const
+    {
+        if (reject.isEmpty() || from < 0 || to < 0 || from >= rejectSize || to >= rejectSize)
+            return false;
+        int bit = from * rejectSize + to;
+        return ((quint8)reject.constData()[bit >> 3] >> (bit & 7)) & 1;
+    }
+
+    // sector to linedef adjacency. linedefs of sector i are sectorLinedefs[sectorLinedefOffsets[i]] up to sectorLinedefOffsets[i+1], in linedef order.
+    // a linedef with both sides in the same sector is listed once.
+    QVector<int> sectorLinedefOffsets;
+    QVector<int> sectorLinedefs;
+    // rebuilds the above. this has to be called after linedefs or sidedefs change sectors.
+    void buildSectorLinedefs();
+
+    // vertex to linedef adjacency, same layout as above.
+    QVector<int> vertexLinedefOffsets;
+    QVector<int> vertexLinedefs;
+    void buildVertexLinedefs();
+
+    // triangulates all sectors. this is split between threads, results are applied in sector order afterwards.
+    void triangulateSectors();
+
+    // half-edge structure with all line loops of the map. it's rebuilt here if geometry was edited since the last call.
+    const DoomMapTopology& getTopology();
+    // crossing, overlapping and touching lines. rebuilt the same way.
+    const DoomMapIntersections& getIntersections();
+
+    // editing. these mark the sectors that depend on changed data as dirty, and updateDirtySectors() retriangulates them in one batch.
+    // geometry edits also invalidate bsp nodes until updateNodes() builds them again.
+    void setVertexPosition(int vertex, float x, float y);
+    void setLinedefVertices(int linedef, int v1, int v2);
+    void setLinedefSidedefs(int linedef, int front, int back);
+    void setSidedefSector(int sidedef, int sector);
+
+    // texture edits. part and plane are DoomMapTextureIndex::SidedefPart and SectorPlane, texture is an id from Tex_GetTextureId.
+    void setSidedefTexture(int sidedef, int part, int texture);
+    void setSectorTexture(int sector, int plane, int texture);
+    // replaces a texture on every surface that has it, as one undo step. returns the number of surfaces changed.
+    int replaceTexture(int from, int to);
+    // texture was reloaded or changed size, views have to rebuild meshes of the surfaces that use it.
+    void markTextureChanged(int texture);
+    // surfaces by texture. kept up to date by the edits above.
+    const DoomMapTextureIndex& getTextureIndex();
+
+    // tag edits. these are sector tags, line ids (tags in Doom format) and thing ids.
+    void setSectorTag(int sector, int tag);
+    void setLinedefId(int linedef, int id);
+    void setThingId(int thing, int id);
+    // components by tag. kept up to date by the edits above.
+    const DoomMapTagIndex& getTagIndex();
+    // sectors that the special of linedef acts on, empty if it has none.
+    // Doom and Strife specials use the line tag. in Hexen and UDMF maps, only specials that take a sector tag in arg0 (doors, floors, lights...) have targets.
+    QVector<int> getLinedefTargetSectors(int linedef);
+    // linedef that has this sidedef on either side, or -1. this only looks at lines of the sidedef's sector.
+    int getSidedefLinedef(int sidedef);
+
+    // vertices, linedefs and sector bounding boxes by position. kept up to date by edits, sectors when they are retriangulated.
+    const DoomMapGrid& getGrid();
+    // sectors that have a vertex within dist of x/y, in no particular order. this only looks at sectors near x/y.
+    QVector<int> getSectorsWithin(float x, float y, float dist);
+
+    // merges vertices that are within tolerance of each other (0 = same position only) and points their linedefs to the one that stays.
+    // linedefs that end up with zero length are removed, and linedefs between the same two vertices are merged into one.
+    // the merged line keeps the special of either line; specials and sidedefs that don't fit are dropped and counted in the result.
+    // this uses a spatial hash, so it's linear and can be used on large maps. it's recorded as one undo step.
+    DoomMapWeldResult weldVertices(float tolerance);
+    // number of vertices weldVertices would merge, without changing anything. loading uses this to ask before welding.
+    int countWeldVertices(float tolerance) const;
+
+    // undo history of the edits above. edits between beginAction and endAction are undone as one step.
+    // undo and redo leave dirty sectors like any other edit. they return false if there was nothing to undo/redo.
+    void beginAction(const QString& name);
+    void endAction();
+    bool canUndo() const;
+    bool canRedo() const;
+    bool undo();
+    bool redo();
+    DoomMapJournal* getJournal() { return journal; }
+
+    void markSectorDirty(int sector);
+    bool hasDirtySectors() const { return !dirtySectors.isEmpty(); }
+    bool hasDirtyNodes() const { return nodesDirty; }
+    // also rebuilds nodes as described in updateNodes(). returns the number of sectors that were retriangulated.
+    int updateDirtySectors();
+
+private:
+    friend class DoomMapSector;
+
+    MapType type;
+
+    // sector triangles and vertex lists. there are a few large blocks instead of two allocations per sector, and closing the map frees them at once.
+    // retriangulated sectors leave their old data behind, so the arena is compacted when that gets large.
+    DoomMapArena arena;
+    qint64 arenaWaste;
+    void compactArena();
+
+    DoomMapJournal* journal;
+    bool journalPaused; // set while undo/redo replays edits, so they aren't recorded again
+    void record(int field, int index, qint32 before0, qint32 before1, qint32 after0, qint32 after1);
+    void applyDelta(const DoomMapDelta& delta, bool undo);
+    // applies or takes back a weld. only sectors around the welded vertices and lines are retriangulated.
+    void applyWeld(const DoomMapWeld& weld, bool undo);
+    void markWeldDirty(const DoomMapWeld& weld);
+    // target of every vertex for a weld, itself if it stays. returns the number of vertices that don't stay.
+    int findWeldTargets(float tolerance, QVector<int>& target) const;
+
+    QByteArray behavior;
+    QString scripts;
+
+    // raw REJECT bit matrix, rejectSize x rejectSize bits. empty if missing, invalid or geometry was edited.
+    QByteArray reject;
+    int rejectSize;
+    void initReject(QByteArray& data);
+
+    DoomMapTopology topology;
+    bool topologyDirty;
+    DoomMapIntersections intersections;
+    bool intersectionsDirty;
+    DoomMapTextureIndex textureIndex;
+    bool textureIndexDirty; // only until the first build, it's updated by edits after that
+    DoomMapTagIndex tagIndex;
+    bool tagIndexDirty; // same, but also after edits that renumber linedefs
+    DoomMapGrid grid;
+    bool gridDirty; // same
+    // vertices or lines moved. bsp nodes, reject, topology and intersections are outdated.
+    void markGeometryChanged();
+    bool nodesDirty;
+    QElapsedTimer nodesTimer; // since the last geometry edit
+
+    QVector<int> dirtySectors;
+    QBitArray dirtySectorBits;
+    bool adjacencyDirty; // lines changed vertices, sidedefs or sectors
+    void markLinedefDirty(int linedef);
+    void updateAdjacency();
+    void triangulateSectors(const QVector<int>& indices);
+
+    void initUDMF(QString text);
+    void initClassic(QIODevice* things, QIODevice* linedefs, QIODevice* sidedefs, QIODevice* vertexes, QIODevice* sectors);
+    void unpackSidedefs();
+};
+
+// what DoomMap::weldVertices changed. sidedefs and specials counted here are lost until the weld is undone.
+struct DoomMapWeldResult
+{
+    DoomMapWeldResult() : vertices(0), linedefs(0), sidedefs(0), specials(0) {}
+
+    int vertices; // merged into another vertex
+    int linedefs; // zero length, or merged into another line
+    int sidedefs; // had no line left
+    int specials; // the line that stayed had another one
+
+    // one line for the status bar
+    QString getSummary() const;
+};
+
+struct DetectedDoomMap
+{
+    QString name;
+    DoomMap::MapType type;
+};
+
+// https://github.com/rheit/zdoom/blob/master/specs/udmf.txt
+// components refer to each other by index in the arrays of the map that contains them, and don't know that map.
+// this keeps them small, and the arrays can grow without leaving anything dangling.
+// fields that don't have a member here are kept in DoomMap::properties.
+class DoomMapComponent
+{
+};
+
+class DoomMapVertex : public DoomMapComponent
+{
+public:
+    float x;
+    float y;
+
+    DoomMapVertex()
+    {
+        x = 0;
+        y = 0;
+    }
+};
+
+class DoomMapSidedef : public DoomMapComponent
+{
+public:
+    int offsetx;
+    int offsety;
+
+    // interned texture names, see Tex_GetTextureId
+    int texturetop;
+    int texturebottom;
+    int texturemiddle;
+
+    int sector;
+
+    // wall geometry changed, views have to rebuild their meshes of this sidedef.
+    bool glupdate;
+
+    DoomMapSidedef()
+    {
+        offsetx = offsety = 0;
+        texturetop = texturebottom = texturemiddle = Tex_NoTextureId;
+        sector = -1;
+        glupdate = false;
+    }
+
+    DoomMapSector* getSector(DoomMap* map)
+    {
+        if (sector < 0 || sector >= map->sectors.size())
+            return 0;
+        return &map->sectors[sector];
+    }
+};
+
+class DoomMapLinedef : public DoomMapComponent
+{
+public:
+    int id;
+    int v1;
+    int v2;
+
+    bool blocking;
+    bool blockmonsters;
+    bool twosided;
+    bool dontpegtop;
+    bool dontpegbottom;
+    bool secret;
+    bool blocksound;
+    bool dontdraw;
+    bool mapped;
+
+    bool passuse;
+
+    bool translucent;
+    bool jumpover;
+    bool blockfloaters;
+
+    bool playercross;
+    bool playeruse;
+    bool monstercross;
+    bool monsteruse;
+    bool impact;
+    bool playerpush;
+    bool monsterpush;
+    bool missilecross;
+    bool repeatspecial;
+
+    int special;
+    int arg0;
+    int arg1;
+    int arg2;
+    int arg3;
+    int arg4;
+
+    int sidefront;
+    int sideback;
+
+    DoomMapLinedef()
+    {
+        id = 0;
+        v1 = -1;
+        v2 = -1;
+
+        blocking = false;
+        blockmonsters = false;
+        twosided = false;
+        dontpegtop = false;
+        dontpegbottom = false;
+        secret = false;
+        blocksound = false;
+        dontdraw = false;
+        mapped = false;
+
+        passuse = false;
+
+        translucent = false;
+        jumpover = false;
+        blockfloaters = false;
+
+        playercross = false;
+        playeruse = false;
+        monstercross = false;
+        monsteruse = false;
+        impact = false;
+        playerpush = false;
+        monsterpush = false;
+        missilecross = false;
+        repeatspecial = false;
+
+        special = 0;
+        arg0 = arg1 = arg2 = arg3 = arg4 = 0;
+
+        sidefront = sideback = -1;
+    }
+
+    // with sector given, v1 and v2 are as seen from that sector, so the sector is always on the right.
+    DoomMapVertex* getV1(DoomMap* map, int sector = -1)
+    {
+        if (sector >= 0 && getFront(map) && getFront(map)->sector != sector)
+            return getV2(map);
+        if (v1 < 0 || v1 >= map->vertices.size())
+            return 0;
+        return &map->vertices[v1];
+    }
+
+    DoomMapVertex* getV2(DoomMap* map, int sector = -1)
+    {
+        if (sector >= 0 && getFront(map) && getFront(map)->sector != sector)
+            return getV1(map);
+        if (v2 < 0 || v2 >= map->vertices.size())
+            return 0;
+        return &map->vertices[v2];
+    }
+
+    // same, for code that only reads the map
+    const DoomMapVertex* getV1(const DoomMap* map, int sector = -1) const
+    {
+        if (sector >= 0 && getFront(map) && getFront(map)->sector != sector)
+            return getV2(map);
+        if (v1 < 0 || v1 >= map->vertices.size())
+            return 0;
+        return &map->vertices.constData()[v1];
+    }
+
+    const DoomMapVertex* getV2(const DoomMap* map, int sector = -1) const
+    {
+        if (sector >= 0 && getFront(map) && getFront(map)->sector != sector)
+            return getV1(map);
+        if (v2 < 0 || v2 >= map->vertices.size())
+            return 0;
+        return &map->vertices.constData()[v2];
+    }
+
+    DoomMapSidedef* getSidedef(DoomMap* map, int sector)
+    {
+        DoomMapSidedef* front = getFront(map);
+        DoomMapSidedef* back = getBack(map);
+        if (front && front->sector == sector) return front;
+        else if (back && back->sector == sector) return back;
+        return 0;
+    }
+
+    DoomMapSidedef* getFront(DoomMap* map)
+    {
+        if (sidefront < 0 || sidefront >= map->sidedefs.size())
+            return 0;
+        return &map->sidedefs[sidefront];
+    }
+
+    DoomMapSidedef* getBack(DoomMap* map)
+    {
+        if (sideback < 0 || sideback >= map->sidedefs.size())
+            return 0;
+        return &map->sidedefs[sideback];
+    }
+
+    const DoomMapSidedef* getFront(const DoomMap* map) const
+    {
+        if (sidefront < 0 || sidefront >= map->sidedefs.size())
+            return 0;
+        return &map->sidedefs.constData()[sidefront];
+    }
+
+    const DoomMapSidedef* getBack(const DoomMap* map) const
+    {
+        if (sideback < 0 || sideback >= map->sidedefs.size())
+            return 0;
+        return &map->sidedefs.constData()[sideback];
+    }
+};
+
+// output of DoomMapSector::computeTriangles. it's built here directly and copied to the map's arena once, by applyTriangles.
+struct DoomMapSectorTriangles
+{
+    QVector<GLVertex> triangles;
+    QVector<int> vertices;
+};
+
+class DoomMapSector : public DoomMapComponent
+{
+public:
+    int heightfloor;
+    int heightceiling;
+
+    int texturefloor;
+    int textureceiling;
+
+    int lightlevel;
+
+    int special;
+    int id;
+
+    DoomMapSector()
+    {
+        heightfloor = heightceiling = 0;
+        texturefloor = textureceiling = Tex_NoTextureId;
+        lightlevel = 160;
+        special = id = 0;
+        glupdate = false;
+    }
+
+    // generate sector triangles. map is the one that has this sector.
+    void triangulate(DoomMap* map);
+    // first half of triangulate. this only reads the map, so different sectors can be done at the same time.
+    // intersections have to be up to date, they aren't rebuilt from here.
+    void computeTriangles(const DoomMap* map, const DoomMapIntersections& intersections, DoomMapSectorTriangles& out) const;
+    // second half. takes the result and marks this sector and its sidedefs for update.
+    void applyTriangles(DoomMap* map, DoomMapSectorTriangles& in);
+
+    int getIndex(const DoomMap* map) const { return this - map->sectors.constData(); }
+
+    // all linedefs of sector, including self referencing. these come from the map's sector adjacency.
+    int getLinedefCount(const DoomMap* map) const
+    {
+        int index = getIndex(map);
+        if (index+1 >= map->sectorLinedefOffsets.size())
+            return 0;
+        return map->sectorLinedefOffsets[index+1] - map->sectorLinedefOffsets[index];
+    }
+
+    DoomMapLinedef* getLinedef(DoomMap* map, int i)
+    {
+        return &map->linedefs[map->sectorLinedefs[map->sectorLinedefOffsets[getIndex(map)]+i]];
+    }
+
+    const DoomMapLinedef* getLinedef(const DoomMap* map, int i) const
+    {
+        return &map->linedefs.constData()[map->sectorLinedefs[map->sectorLinedefOffsets[getIndex(map)]+i]];
+    }
+
+    // these are in the map's arena.
+    DoomMapSpan<GLVertex> triangles; // this is at height 0. views make their own floor/ceiling meshes from it, for slopes.
+    DoomMapSpan<int> vertices; // all vertices of sector, by index.
+    QRectF boundingBox; // bounding box of sector.
+
+    // triangles changed, views have to rebuild their meshes of this sector.
+    bool glupdate;
+
+    void updateBoundingBox(const DoomMap* map)
+    {
+        float xMin = 65536;
+        float xMax = -65536;
+        float yMin = 65536;
+        float yMax = -65536;
+
+        for (int i = 0; i < vertices.size(); i++)
+        {
+            float x = map->vertices[vertices[i]].x;
+            float y = map->vertices[vertices[i]].y;
+            if (x < xMin) xMin = x;
+            if (x > xMax) xMax = x;
+            if (y < yMin) yMin = y;
+            if (y > yMax) yMax = y;
+        }
+
+        boundingBox = QRectF(xMin, yMin, xMax-xMin, yMax-yMin);
+    }
+
+    bool isAnyWithin(const DoomMap* map, float x, float y, float dst)
+    {
+        //
+        // check bounding box within
+        if (!boundingBox.adjusted(-dst, -dst, +dst, +dst).contains(x, y))
+            return false;
+
+        float dst2 = dst * dst;
+        for (int i = 0; i < vertices.size(); i++)
+        {
+            const DoomMapVertex& v = map->vertices[vertices[i]];
+            if ((v.x-x)*(v.x-x) + (v.y-y)*(v.y-y) <= dst2)
+                return true;
+        }
+
+        return false;
+    }
+
+    // todo slope calculations
+    float zatFloor(float x, float y)
+    {
+        return heightfloor;
+    }
+
+    float zatCeiling(float x, float y)
+    {
+        return heightceiling;
+    }
+};
+
+class SectorPolygonTracer
+{
+public:
+    SectorPolygonTracer(const DoomMap* map, int sector)
+    {
+        this->map = map;
+        this->sector = sector;
+        linedefs.clear();
+
+        const DoomMapSector& sec = map->sectors.constData()[sector];
+        int count = sec.getLinedefCount(map);
+        alllinedefs.reserve(count);
+        for (int i = 0; i < count; i++)
+        {
+            const DoomMapLinedef* linedef = sec.getLinedef(map, i);
+            const DoomMapSidedef* front = linedef->getFront(map);
+            const DoomMapSidedef* back = linedef->getBack(map);
+
+            bool hfront = (front && front->sector == sector);
+            bool hback = (back && back->sector == sector);
+
+            alllinedefs.append(linedef);
+            if (!hfront || !hback)
+                linedefs.append(linedef);
+        }
+
+        buildOutgoing();
+    }
+
+    // returns linedefs that refer to this sector with one of their sidedefs
+    QVector<const DoomMapLinedef*> getLinedefs()
+    {
+        return linedefs;
+    }
+
+    QVector<const DoomMapLinedef*> getAllLinedefs()
+    {
+        return alllinedefs;
+    }
+
+    // returns a list of separate line loops in this sector.
+    QVector<QPolygonF> getPolygons()
+    {
+        QVector<QPolygonF> polygons;
+        int nextld = 0;
+        while (true)
+        {
+            // find first unchecked line. lines never get unchecked, so continue from the previous one.
+            while (nextld < linedefs.size() && checkedlinedefs.testBit(nextld))
+                nextld++;
+
+            if (nextld >= linedefs.size())
+                break;
+
+            QPair< QPolygonF, QVector<int> > poly = nextPolygon(nextld);
+            if (poly.first.size() <= 0)
+                break;
+            polygons.append(poly.first);
+            for (int i = 0; i < poly.second.size(); i++)
+                checkedlinedefs.setBit(poly.second[i]);
+        }
+
+        return polygons;
+    }
+
+private:
+
+    const DoomMap* map;
+    int sector;
+
+    // a list of linedefs in the reference sector.
+    QVector<const DoomMapLinedef*> alllinedefs; // including self referencing
+    QVector<const DoomMapLinedef*> linedefs;
+
+    // linedefs that have already been traversed, by index in linedefs.
+    QBitArray checkedlinedefs;
+
+    // lines going out of every vertex position (v1 as seen from this sector).
+    // outgoing maps position to the first line, nextoutgoing links to the next line from the same position, -1 ends the list.
+    QHash<quint64, int> outgoing;
+    QVector<int> nextoutgoing;
+    void buildOutgoing();
+
+    // exact position key. vertices with the same coordinates are considered the same vertex.
+    static quint64 positionKey(float x, float y);
+
+    // returns a pair of polygon and lines (indices in linedefs) that this polygon consists of.
+    // if no polygon found, returns two empty objects.
+    QPair< QPolygonF, QVector<int> > nextPolygon(int line);
+};
+
+#endif // DOOMMAP_H
@@ -0,0 +1,64 @@
+#include "doommaparena.h"
+#include <cstdlib>
+
+DoomMapArena::DoomMapArena(int blockSize)
+{
+    this->blockSize = blockSize;
+    current = -1;
+    offset = 0;
+    used = 0;
+}
+
+DoomMapArena::~DoomMapArena()
+{
+    clear();
+}
+
+void* DoomMapArena::allocate(int size, int align)
+{
+    if (size <= 0)
+        return 0;
+
+    if (current >= 0)
+    {
+        const Block& block = blocks[current];
+        int start = (offset + align - 1) & ~(align - 1);
+        if (start + size <= block.size)
+        {
+            offset = start + size;
+            used += size;
+            return block.data + start;
+        }
+    }
+
+    // malloc alignment is enough for everything that goes here
+    Block block;
+    block.size = qMax(blockSize, size);
+    block.data = (char*)malloc(block.size);
+    if (!block.data)
+        return 0;
+    blocks.append(block);
+    current = blocks.size()-1;
+    offset = size;
+    used += size;
+    return block.data;
+}
+
+void DoomMapArena::clear()
+{
+    for (int i = 0; i < blocks.size(); i++)
+        free(blocks[i].data);
+    blocks.clear();
+    current = -1;
+    offset = 0;
+    used = 0;
+}
+
+void DoomMapArena::swap(DoomMapArena& other)
+{
+    blocks.swap(other.blocks);
+    qSwap(blockSize, other.blockSize);
+    qSwap(current, other.current);
+    qSwap(offset, other.offset);
+    qSwap(used, other.used);
+}
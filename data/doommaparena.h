@@ -0,0 +1,78 @@
+#ifndef DOOMMAPARENA_H
+#define DOOMMAPARENA_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <cstring>
+
+// array that lives in a DoomMapArena. it's just a pointer and a count, copying it doesn't copy the data.
+template<typename T> struct DoomMapSpan
+{
+    DoomMapSpan() : data(0), count(0) {}
+
+    T* data;
+    int count;
+
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    T& operator[](int i) { return data[i]; }
+    const T& operator[](int i) const { return data[i]; }
+};
+
+// bump allocator. memory comes in large blocks, so there is one malloc per block instead of one per object,
+// and everything is released at once by clear() or the destructor.
+// destructors are never called, so this is only for plain data like vertices, indices and points.
+class DoomMapArena
+{
+public:
+    DoomMapArena(int blockSize = 256*1024);
+    ~DoomMapArena();
+
+    void* allocate(int size, int align);
+
+    template<typename T> DoomMapSpan<T> allocate(int count)
+    {
+        DoomMapSpan<T> span;
+        span.data = (T*)allocate(count * sizeof(T), Q_ALIGNOF(T));
+        span.count = span.data ? count : 0;
+        return span;
+    }
+
+    template<typename T> DoomMapSpan<T> copy(const T* data, int count)
+    {
+        DoomMapSpan<T> span = allocate<T>(count);
+        if (span.count)
+            memcpy(span.data, data, count * sizeof(T));
+        return span;
+    }
+
+    template<typename T> DoomMapSpan<T> copy(const QVector<T>& data) { return copy(data.constData(), data.size()); }
+
+    // frees all blocks
+    void clear();
+
+    void swap(DoomMapArena& other);
+
+    // bytes handed out since the start
+    qint64 getUsed() const { return used; }
+    int getBlockCount() const { return blocks.size(); }
+
+private:
+    struct Block
+    {
+        char* data;
+        int size;
+    };
+
+    QVector<Block> blocks;
+    int blockSize;
+    int current; // block being filled, -1 if none yet
+    int offset; // in current block
+    qint64 used;
+
+    // not copyable, spans point into the blocks
+    DoomMapArena(const DoomMapArena&);
+    DoomMapArena& operator=(const DoomMapArena&);
+};
+
+#endif // DOOMMAPARENA_H
@@ -0,0 +1,377 @@
+#include "doommapgrid.h"
+#include "doommap.h"
+#include <cmath>
+
+DoomMapGrid::DoomMapGrid()
+{
+    map = 0;
+    originX = originY = 0;
+    width = height = 0;
+}
+
+void DoomMapGrid::clear()
+{
+    map = 0;
+    width = height = 0;
+    for (int i = 0; i < NumLayers; i++)
+        layers[i] = DoomMapGridLayer();
+}
+
+void DoomMapGrid::build(const DoomMap* map)
+{
+    clear();
+    this->map = map;
+
+    double xMin = 0, xMax = 0, yMin = 0, yMax = 0;
+    for (int i = 0; i < map->vertices.size(); i++)
+    {
+        const DoomMapVertex& v = map->vertices[i];
+        if (!i || v.x < xMin) xMin = v.x;
+        if (!i || v.x > xMax) xMax = v.x;
+        if (!i || v.y < yMin) yMin = v.y;
+        if (!i || v.y > yMax) yMax = v.y;
+    }
+
+    originX = floor(xMin / CellSize) * CellSize;
+    originY = floor(yMin / CellSize) * CellSize;
+    width = (int)floor((xMax - originX) / CellSize) + 1;
+    height = (int)floor((yMax - originY) / CellSize) + 1;
+
+    for (int i = 0; i < NumLayers; i++)
+        layers[i].cells.resize(width * height);
+
+    for (int i = 0; i < map->vertices.size(); i++)
+        insert(Vertices, i);
+    for (int i = 0; i < map->linedefs.size(); i++)
+        insert(Linedefs, i);
+    for (int i = 0; i < map->sectors.size(); i++)
+        insert(Sectors, i);
+}
+
+int DoomMapGrid::cellX(double x) const
+{
+    double c = floor((x - originX) / CellSize);
+    if (c < 0) return 0;
+    if (c >= width) return width-1;
+    return (int)c;
+}
+
+int DoomMapGrid::cellY(double y) const
+{
+    double c = floor((y - originY) / CellSize);
+    if (c < 0) return 0;
+    if (c >= height) return height-1;
+    return (int)c;
+}
+
+DoomMapGridCells DoomMapGrid::getCells(const QRectF& rect) const
+{
+    DoomMapGridCells cells;
+    cells.x0 = cellX(rect.left());
+    cells.x1 = cellX(rect.right());
+    cells.y0 = cellY(rect.top());
+    cells.y1 = cellY(rect.bottom());
+    return cells;
+}
+
+void DoomMapGrid::insert(Layer layer, int item)
+{
+    DoomMapGridLayer& l = layers[layer];
+    while (l.items.size() <= item)
+    {
+        l.items.append(DoomMapGridCells());
+        l.stamps.append(0);
+    }
+
+    DoomMapGridCells cells;
+    if (layer == Vertices)
+    {
+        const DoomMapVertex& v = map->vertices[item];
+        cells.x0 = cells.x1 = cellX(v.x);
+        cells.y0 = cells.y1 = cellY(v.y);
+        l.cells[cells.y0 * width + cells.x0].append(item);
+    }
+    else if (layer == Sectors)
+    {
+        // sectors without vertices don't have a bounding box
+        const DoomMapSector& sector = map->sectors[item];
+        if (sector.vertices.size())
+        {
+            cells = getCells(sector.boundingBox);
+            for (int cy = cells.y0; cy <= cells.y1; cy++)
+                for (int cx = cells.x0; cx <= cells.x1; cx++)
+                    l.cells[cy * width + cx].append(item);
+        }
+    }
+    else if (layer == Linedefs)
+    {
+        const DoomMapLinedef& linedef = map->linedefs[item];
+        if (linedef.v1 >= 0 && linedef.v1 < map->vertices.size() && linedef.v2 >= 0 && linedef.v2 < map->vertices.size())
+        {
+            double ax = map->vertices[linedef.v1].x;
+            double ay = map->vertices[linedef.v1].y;
+            double bx = map->vertices[linedef.v2].x;
+            double by = map->vertices[linedef.v2].y;
+            cells = getCells(QRectF(QPointF(qMin(ax, bx), qMin(ay, by)), QPointF(qMax(ax, bx), qMax(ay, by))));
+
+            // only cells that the line passes through, row by row. border rows go on forever, see cellY.
+            // the x range is widened a bit, so rounding never loses a cell that the line only touches.
+            for (int cy = cells.y0; cy <= cells.y1; cy++)
+            {
+                double rowMin = (cy == 0) ? -1e30 : originY + cy * CellSize;
+                double rowMax = (cy == height-1) ? 1e30 : originY + (cy+1) * CellSize;
+                double y0 = qMax(qMin(ay, by), rowMin);
+                double y1 = qMin(qMax(ay, by), rowMax);
+                double x0 = ax;
+                double x1 = bx;
+                if (ay != by)
+                {
+                    x0 = ax + (y0 - ay) * (bx - ax) / (by - ay);
+                    x1 = ax + (y1 - ay) * (bx - ax) / (by - ay);
+                }
+
+                int c0 = cellX(qMin(x0, x1) - 1.0/256);
+                int c1 = cellX(qMax(x0, x1) + 1.0/256);
+                for (int cx = c0; cx <= c1; cx++)
+                    l.cells[cy * width + cx].append(item);
+            }
+        }
+    }
+
+    l.items[item] = cells;
+}
+
+// item is looked for in every cell of its old rectangle, cells have few items so that's cheap.
+void DoomMapGrid::remove(Layer layer, int item)
+{
+    DoomMapGridLayer& l = layers[layer];
+    if (item >= l.items.size())
+        return;
+
+    const DoomMapGridCells& cells = l.items[item];
+    for (int cy = cells.y0; cy <= cells.y1; cy++)
+    {
+        for (int cx = cells.x0; cx <= cells.x1; cx++)
+        {
+            QVector<int>& cell = l.cells[cy * width + cx];
+            int i = cell.indexOf(item);
+            if (i < 0)
+                continue;
+            cell[i] = cell.last();
+            cell.removeLast();
+        }
+    }
+
+    l.items[item] = DoomMapGridCells();
+}
+
+void DoomMapGrid::updateVertex(int vertex)
+{
+    if (!map || vertex < 0 || vertex >= map->vertices.size())
+        return;
+    remove(Vertices, vertex);
+    insert(Vertices, vertex);
+}
+
+void DoomMapGrid::updateLinedef(int linedef)
+{
+    if (!map || linedef < 0 || linedef >= map->linedefs.size())
+        return;
+    remove(Linedefs, linedef);
+    insert(Linedefs, linedef);
+}
+
+void DoomMapGrid::updateSector(int sector)
+{
+    if (!map || sector < 0 || sector >= map->sectors.size())
+        return;
+    remove(Sectors, sector);
+    insert(Sectors, sector);
+}
+
+double DoomMapGrid::distance2(Layer layer, int item, double x, double y) const
+{
+    if (layer == Vertices)
+    {
+        double dx = map->vertices[item].x - x;
+        double dy = map->vertices[item].y - y;
+        return dx*dx + dy*dy;
+    }
+    else if (layer == Linedefs)
+    {
+        const DoomMapLinedef& linedef = map->linedefs[item];
+        double ax = map->vertices[linedef.v1].x;
+        double ay = map->vertices[linedef.v1].y;
+        double dx = map->vertices[linedef.v2].x - ax;
+        double dy = map->vertices[linedef.v2].y - ay;
+        double len2 = dx*dx + dy*dy;
+        double t = len2 > 0 ? ((x - ax) * dx + (y - ay) * dy) / len2 : 0;
+        t = qBound(0.0, t, 1.0);
+        double px = ax + dx * t - x;
+        double py = ay + dy * t - y;
+        return px*px + py*py;
+    }
+    else
+    {
+        const QRectF& box = map->sectors[item].boundingBox;
+        double dx = qMax(qMax(box.left() - x, 0.0), x - box.right());
+        double dy = qMax(qMax(box.top() - y, 0.0), y - box.bottom());
+        return dx*dx + dy*dy;
+    }
+}
+
+bool DoomMapGrid::isInRect(Layer layer, int item, const QRectF& rect) const
+{
+    // not QRectF::intersects, it says no for horizontal and vertical lines
+    double xMin, xMax, yMin, yMax;
+    if (layer == Vertices)
+    {
+        xMin = xMax = map->vertices[item].x;
+        yMin = yMax = map->vertices[item].y;
+    }
+    else if (layer == Linedefs)
+    {
+        const DoomMapVertex& v1 = map->vertices[map->linedefs[item].v1];
+        const DoomMapVertex& v2 = map->vertices[map->linedefs[item].v2];
+        xMin = qMin(v1.x, v2.x);
+        xMax = qMax(v1.x, v2.x);
+        yMin = qMin(v1.y, v2.y);
+        yMax = qMax(v1.y, v2.y);
+    }
+    else
+    {
+        const QRectF& box = map->sectors[item].boundingBox;
+        xMin = box.left();
+        xMax = box.right();
+        yMin = box.top();
+        yMax = box.bottom();
+    }
+
+    return xMax >= rect.left() && xMin <= rect.right() && yMax >= rect.top() && yMin <= rect.bottom();
+}
+
+QVector<int> DoomMapGrid::queryRect(Layer layer, const QRectF& rect) const
+{
+    QVector<int> result;
+    if (!map || layer < 0 || layer >= NumLayers)
+        return result;
+
+    QRectF r = rect.normalized();
+    DoomMapGridLayer& l = layers[layer];
+    l.stamp++;
+    DoomMapGridCells cells = getCells(r);
+    for (int cy = cells.y0; cy <= cells.y1; cy++)
+    {
+        for (int cx = cells.x0; cx <= cells.x1; cx++)
+        {
+            const QVector<int>& cell = l.cells[cy * width + cx];
+            for (int i = 0; i < cell.size(); i++)
+            {
+                int item = cell[i];
+                if (l.stamps[item] == l.stamp)
+                    continue;
+                l.stamps[item] = l.stamp;
+                if (isInRect(layer, item, r))
+                    result.append(item);
+            }
+        }
+    }
+
+    return result;
+}
+
+QVector<int> DoomMapGrid::queryRadius(Layer layer, float x, float y, float radius) const
+{
+    QVector<int> result;
+    if (!map || layer < 0 || layer >= NumLayers)
+        return result;
+
+    double radius2 = (double)radius * radius;
+    DoomMapGridLayer& l = layers[layer];
+    l.stamp++;
+    DoomMapGridCells cells = getCells(QRectF(x - radius, y - radius, radius * 2, radius * 2));
+    for (int cy = cells.y0; cy <= cells.y1; cy++)
+    {
+        for (int cx = cells.x0; cx <= cells.x1; cx++)
+        {
+            const QVector<int>& cell = l.cells[cy * width + cx];
+            for (int i = 0; i < cell.size(); i++)
+            {
+                int item = cell[i];
+                if (l.stamps[item] == l.stamp)
+                    continue;
+                l.stamps[item] = l.stamp;
+                if (distance2(layer, item, x, y) <= radius2)
+                    result.append(item);
+            }
+        }
+    }
+
+    return result;
+}
+
+int DoomMapGrid::nearest(Layer layer, float x, float y, float maxDistance) const
+{
+    if (!map || (layer != Vertices && layer != Linedefs))
+        return -1;
+
+    DoomMapGridLayer& l = layers[layer];
+    l.stamp++;
+    int cx = cellX(x);
+    int cy = cellY(y);
+    int best = -1;
+    double best2 = (double)maxDistance * maxDistance;
+    for (int k = 0; k <= width + height; k++)
+    {
+        // everything that's left is outside of the rings searched so far. stop when that's further than the best one.
+        // edges of the grid don't count, items outside of it are in the border cells.
+        if (k > 0)
+        {
+            int x0 = cx - (k-1);
+            int x1 = cx + (k-1);
+            int y0 = cy - (k-1);
+            int y1 = cy + (k-1);
+            if (x0 <= 0 && y0 <= 0 && x1 >= width-1 && y1 >= height-1)
+                break;
+
+            double bound = 1e30;
+            if (x0 > 0) bound = qMin(bound, x - (originX + x0 * CellSize));
+            if (x1 < width-1) bound = qMin(bound, originX + (x1+1) * CellSize - x);
+            if (y0 > 0) bound = qMin(bound, y - (originY + y0 * CellSize));
+            if (y1 < height-1) bound = qMin(bound, originY + (y1+1) * CellSize - y);
+            if (bound > 0 && bound * bound > best2)
+                break;
+        }
+
+        for (int j = cy - k; j <= cy + k; j++)
+        {
+            if (j < 0 || j >= height)
+                continue;
+
+            // full rows at the top and bottom of the ring, only the two ends in between
+            int step = (j == cy - k || j == cy + k) ? 1 : 2*k;
+            for (int i = cx - k; i <= cx + k; i += step)
+            {
+                if (i < 0 || i >= width)
+                    continue;
+
+                const QVector<int>& cell = l.cells[j * width + i];
+                for (int n = 0; n < cell.size(); n++)
+                {
+                    int item = cell[n];
+                    if (l.stamps[item] == l.stamp)
+                        continue;
+                    l.stamps[item] = l.stamp;
+                    double d2 = distance2(layer, item, x, y);
+                    if (d2 < best2 || (best < 0 && d2 <= best2))
+                    {
+                        best = item;
+                        best2 = d2;
+                    }
+                }
+            }
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,83 @@
+#ifndef DOOMMAPGRID_H
+#define DOOMMAPGRID_H
+
+#include <QVector>
+#include <QRectF>
+
+class DoomMap;
+
+// cells that one item is in. x1 < x0 if none.
+struct DoomMapGridCells
+{
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+
+    DoomMapGridCells() : x0(0), y0(0), x1(-1), y1(-1) {}
+};
+
+struct DoomMapGridLayer
+{
+    QVector< QVector<int> > cells; // items in every cell, row by row
+    QVector<DoomMapGridCells> items; // where every item was put
+    // items already returned by the current query, so items in several cells are returned once
+    QVector<int> stamps;
+    int stamp;
+
+    DoomMapGridLayer() { stamp = 0; }
+};
+
+// uniform grid over the map, like the blockmap: vertices, linedefs (every cell they pass through) and sector bounding boxes.
+// the grid covers the map as it was when built. things that were moved out of it later are kept in the border cells, so queries stay correct.
+// DoomMap updates this on edits, so both views can use it instead of looking at every component.
+// queries are const, but they aren't thread safe.
+class DoomMapGrid
+{
+public:
+    enum Layer
+    {
+        Vertices,
+        Linedefs,
+        Sectors,
+        NumLayers
+    };
+
+    static const int CellSize = 128;
+
+    DoomMapGrid();
+
+    void build(const DoomMap* map);
+    void clear();
+
+    // component moved or changed shape. the new position is read from the map.
+    void updateVertex(int vertex);
+    void updateLinedef(int linedef);
+    void updateSector(int sector);
+
+    // vertices inside rect. linedefs and sectors with the bounding box touching rect.
+    QVector<int> queryRect(Layer layer, const QRectF& rect) const;
+    // vertices and linedefs not further than radius from x/y. sectors with the bounding box not further than radius.
+    QVector<int> queryRadius(Layer layer, float x, float y, float radius) const;
+    // nearest vertex or linedef, or -1 if there is none within maxDistance. cells are searched in rings around x/y.
+    int nearest(Layer layer, float x, float y, float maxDistance) const;
+
+private:
+    const DoomMap* map;
+    double originX;
+    double originY;
+    int width;
+    int height;
+    mutable DoomMapGridLayer layers[NumLayers];
+
+    int cellX(double x) const;
+    int cellY(double y) const;
+    void insert(Layer layer, int item);
+    void remove(Layer layer, int item);
+    DoomMapGridCells getCells(const QRectF& rect) const;
+    // squared distance from x/y to item, or to its bounding box for sectors
+    double distance2(Layer layer, int item, double x, double y) const;
+    bool isInRect(Layer layer, int item, const QRectF& rect) const;
+};
+
+#endif // DOOMMAPGRID_H
@@ -0,0 +1,460 @@
+#include "doommapintersections.h"
+#include "doommap.h"
+#include "geometry.h"
+#include <QSet>
+#include <algorithm>
+#include <queue>
+#include <set>
+
+// line going from left to right (or bottom to top if vertical)
+struct DoomMapIntersections_Line
+{
+    FixedPoint v1;
+    FixedPoint v2;
+    int linedef;
+};
+
+static bool DoomMapIntersections_PointLess(double x1, double y1, double x2, double y2)
+{
+    return x1 < x2 || (x1 == x2 && y1 < y2);
+}
+
+static bool DoomMapIntersections_PointLess(const FixedPoint& a, const FixedPoint& b)
+{
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+// > 0 if p is above (left of) the line, < 0 if below, 0 if on it
+static qint64 DoomMapIntersections_Orient(const DoomMapIntersections_Line& l, const FixedPoint& p)
+{
+    return Geometry::orient(l.v1, l.v2, p);
+}
+
+// point is strictly between the ends of a line it's collinear with
+static bool DoomMapIntersections_Inside(const DoomMapIntersections_Line& l, const FixedPoint& p)
+{
+    return DoomMapIntersections_PointLess(l.v1, p) && DoomMapIntersections_PointLess(p, l.v2);
+}
+
+// -1 if lines only meet at their ends or not at all
+static int DoomMapIntersections_Classify(const DoomMapIntersections_Line& a, const DoomMapIntersections_Line& b, QPointF& point)
+{
+    qint64 o1 = DoomMapIntersections_Orient(a, b.v1);
+    qint64 o2 = DoomMapIntersections_Orient(a, b.v2);
+    qint64 o3 = DoomMapIntersections_Orient(b, a.v1);
+    qint64 o4 = DoomMapIntersections_Orient(b, a.v2);
+
+    if (o1 == 0 && o2 == 0)
+    {
+        // same line. both go the same direction, so they overlap if the later start is before the earlier end.
+        FixedPoint start = DoomMapIntersections_PointLess(b.v1, a.v1) ? a.v1 : b.v1;
+        FixedPoint end = DoomMapIntersections_PointLess(a.v2, b.v2) ? a.v2 : b.v2;
+        if (!DoomMapIntersections_PointLess(start, end))
+            return -1;
+
+        point = Geometry::toMap(start);
+        return DoomMapIntersection::Overlap;
+    }
+
+    if (Geometry::sign(o1) * Geometry::sign(o2) < 0 && Geometry::sign(o3) * Geometry::sign(o4) < 0)
+    {
+        // the point is rounded, keep it inside both lines. the sweep must not see it after the end of either.
+        double t = (double)o1 / (double)(o1 - o2);
+        double x = b.v1.x + (b.v2.x - b.v1.x) * t;
+        double y = b.v1.y + (b.v2.y - b.v1.y) * t;
+        x = qBound((double)qMax(a.v1.x, b.v1.x), x, (double)qMin(a.v2.x, b.v2.x));
+        y = qBound((double)qMax(qMin(a.v1.y, a.v2.y), qMin(b.v1.y, b.v2.y)), y, (double)qMin(qMax(a.v1.y, a.v2.y), qMax(b.v1.y, b.v2.y)));
+        point = QPointF(x / Geometry::One, y / Geometry::One);
+        return DoomMapIntersection::Crossing;
+    }
+
+    if (o1 == 0 && DoomMapIntersections_Inside(a, b.v1)) point = Geometry::toMap(b.v1);
+    else if (o2 == 0 && DoomMapIntersections_Inside(a, b.v2)) point = Geometry::toMap(b.v2);
+    else if (o3 == 0 && DoomMapIntersections_Inside(b, a.v1)) point = Geometry::toMap(a.v1);
+    else if (o4 == 0 && DoomMapIntersections_Inside(b, a.v2)) point = Geometry::toMap(a.v2);
+    else return -1;
+
+    return DoomMapIntersection::Touch;
+}
+
+struct DoomMapIntersections_Sweep;
+
+// lines in the sweep status are ordered bottom to top.
+// this is only ever asked to place a line that goes through the current event point (or the point itself, as line -1),
+// so it compares against the event point instead of evaluating lines at the sweep position, which keeps it exact.
+struct DoomMapIntersections_StatusLess
+{
+    const DoomMapIntersections_Sweep* sweep;
+    bool operator()(int a, int b) const;
+};
+
+struct DoomMapIntersections_Event
+{
+    FixedPoint p;
+    int line;
+    bool start;
+
+    bool operator<(const DoomMapIntersections_Event& other) const
+    {
+        return DoomMapIntersections_PointLess(p, other.p);
+    }
+};
+
+// lower and upper are neighbours in the status that will swap at x/y.
+// this is a rounded crossing point in map units. it only orders swaps against events, and nothing is tested against it.
+struct DoomMapIntersections_Swap
+{
+    double x, y;
+    int lower;
+    int upper;
+
+    // reversed, std::priority_queue takes the largest first
+    bool operator<(const DoomMapIntersections_Swap& other) const
+    {
+        return DoomMapIntersections_PointLess(other.x, other.y, x, y);
+    }
+};
+
+struct DoomMapIntersections_Sweep
+{
+    typedef std::set<int, DoomMapIntersections_StatusLess> Status;
+
+    QVector<DoomMapIntersections_Line> lines;
+    QVector<DoomMapIntersection>* out;
+
+    Status status;
+    QVector<Status::iterator> positions; // where every active line is in status
+    QVector<char> state; // 0 = not reached yet, 1 = in status, 2 = done
+    std::priority_queue<DoomMapIntersections_Swap> swaps;
+    QSet<quint64> reported;
+
+    // current event point. events are line ends, so this is always exact.
+    FixedPoint p;
+
+    DoomMapIntersections_Sweep()
+    {
+        DoomMapIntersections_StatusLess less;
+        less.sweep = this;
+        status = Status(less);
+        out = 0;
+    }
+
+    bool contains(int line) const
+    {
+        return DoomMapIntersections_Orient(lines[line], p) == 0;
+    }
+
+    // line a goes through the event point. returns true if it's below line b right after the point.
+    bool below(int a, int b) const
+    {
+        const DoomMapIntersections_Line& la = lines[a];
+        const DoomMapIntersections_Line& lb = lines[b];
+        qint64 o = DoomMapIntersections_Orient(lb, p);
+        if (o != 0)
+            return o < 0;
+
+        // both go through the point, the one that goes down more is below
+        qint64 cross = Geometry::cross(la.v2 - la.v1, lb.v2 - lb.v1);
+        if (cross != 0)
+            return cross > 0;
+        return a < b;
+    }
+
+    void report(int a, int b, int type, const QPointF& point)
+    {
+        int l1 = qMin(lines[a].linedef, lines[b].linedef);
+        int l2 = qMax(lines[a].linedef, lines[b].linedef);
+        quint64 key = ((quint64)(quint32)l1 << 32) | (quint32)l2;
+        if (reported.contains(key))
+            return;
+        reported.insert(key);
+
+        DoomMapIntersection i;
+        i.linedef1 = l1;
+        i.linedef2 = l2;
+        i.type = (DoomMapIntersection::Type)type;
+        i.point = point;
+        out->append(i);
+    }
+
+    // lower and upper cross somewhere after the sweep position. exact: they cross, and their order at the end of the shorter one is reversed.
+    bool willSwap(int lower, int upper) const
+    {
+        const DoomMapIntersections_Line& a = lines[lower];
+        const DoomMapIntersections_Line& b = lines[upper];
+        if (DoomMapIntersections_PointLess(a.v2, b.v2))
+            return DoomMapIntersections_Orient(b, a.v2) > 0;
+        return DoomMapIntersections_Orient(a, b.v2) < 0;
+    }
+
+    void check(Status::iterator lower, Status::iterator upper)
+    {
+        if (lower == status.end() || upper == status.end())
+            return;
+
+        QPointF point;
+        if (DoomMapIntersections_Classify(lines[*lower], lines[*upper], point) != DoomMapIntersection::Crossing)
+            return;
+        if (!willSwap(*lower, *upper))
+            return;
+
+        DoomMapIntersections_Swap s;
+        s.x = point.x();
+        s.y = point.y();
+        s.lower = *lower;
+        s.upper = *upper;
+        swaps.push(s);
+    }
+
+    Status::iterator prev(Status::iterator it)
+    {
+        return it == status.begin() ? status.end() : --it;
+    }
+
+    Status::iterator next(Status::iterator it)
+    {
+        return it == status.end() ? it : ++it;
+    }
+
+    void doSwap(const DoomMapIntersections_Swap& s)
+    {
+        // this is stale if something else got between them, or they were already swapped
+        if (state[s.lower] != 1 || state[s.upper] != 1)
+            return;
+        if (next(positions[s.lower]) != positions[s.upper] || !willSwap(s.lower, s.upper))
+            return;
+
+        // lines are swapped in place. the set is not asked to compare them, so it doesn't have to know.
+        const_cast<int&>(*positions[s.lower]) = s.upper;
+        const_cast<int&>(*positions[s.upper]) = s.lower;
+        qSwap(positions[s.lower], positions[s.upper]);
+        report(s.lower, s.upper, DoomMapIntersection::Crossing, QPointF(s.x, s.y));
+
+        check(prev(positions[s.upper]), positions[s.upper]);
+        check(positions[s.lower], next(positions[s.lower]));
+    }
+
+    // all lines that start, end or pass through p
+    void doPoint(const QVector<int>& starts, const QVector<int>& ends)
+    {
+        // lines going through the point are next to each other in status
+        QVector<int> through;
+        for (Status::iterator it = status.lower_bound(-1); it != status.end() && contains(*it); ++it)
+            through.append(*it);
+
+        // ending lines should always be found above, but don't lose them if rounding put them elsewhere
+        for (int i = 0; i < ends.size(); i++)
+        {
+            if (state[ends[i]] == 1 && !through.contains(ends[i]))
+                through.append(ends[i]);
+        }
+
+        // a crossing right before the end of a line can be rounded past it. neighbours of ending lines are checked one last time.
+        for (int i = 0; i < ends.size(); i++)
+        {
+            if (state[ends[i]] != 1)
+                continue;
+
+            Status::iterator it = positions[ends[i]];
+            Status::iterator around[2] = { prev(it), next(it) };
+            for (int j = 0; j < 2; j++)
+            {
+                QPointF point;
+                if (around[j] != status.end() && !through.contains(*around[j]) &&
+                    DoomMapIntersections_Classify(lines[ends[i]], lines[*around[j]], point) == DoomMapIntersection::Crossing)
+                    report(ends[i], *around[j], DoomMapIntersection::Crossing, point);
+            }
+        }
+
+        QVector<int> all = through + starts;
+        for (int i = 0; i < all.size(); i++)
+        {
+            for (int j = i+1; j < all.size(); j++)
+            {
+                QPointF point;
+                int type = DoomMapIntersections_Classify(lines[all[i]], lines[all[j]], point);
+                if (type >= 0)
+                    report(all[i], all[j], type, point);
+            }
+        }
+
+        // remove everything through the point, and put back what continues after it. this also reorders lines crossing here.
+        QVector<int> inserted = starts;
+        for (int i = 0; i < through.size(); i++)
+        {
+            int line = through[i];
+            status.erase(positions[line]);
+            if (lines[line].v2 == p)
+                state[line] = 2;
+            else inserted.append(line);
+        }
+
+        for (int i = 0; i < inserted.size(); i++)
+        {
+            int line = inserted[i];
+            positions[line] = status.insert(line).first;
+            state[line] = 1;
+        }
+
+        Status::iterator first = status.lower_bound(-1);
+        if (inserted.isEmpty())
+        {
+            check(prev(first), first);
+            return;
+        }
+
+        Status::iterator last = first;
+        while (next(last) != status.end() && contains(*next(last)))
+            ++last;
+
+        check(prev(first), first);
+        check(last, next(last));
+    }
+
+    void run()
+    {
+        QVector<DoomMapIntersections_Event> events;
+        events.reserve(lines.size()*2);
+        for (int i = 0; i < lines.size(); i++)
+        {
+            DoomMapIntersections_Event e;
+            e.line = i;
+            e.p = lines[i].v1;
+            e.start = true;
+            events.append(e);
+            e.p = lines[i].v2;
+            e.start = false;
+            events.append(e);
+        }
+
+        std::sort(events.begin(), events.end());
+        positions.resize(lines.size());
+        state.fill(0, lines.size());
+
+        QVector<int> starts;
+        QVector<int> ends;
+        int e = 0;
+        while (e < events.size() || !swaps.empty())
+        {
+            // swaps at the same position as an event point are handled by the event point
+            if (!swaps.empty() && (e >= events.size() ||
+                                   DoomMapIntersections_PointLess(swaps.top().x, swaps.top().y, Geometry::toMap(events[e].p.x), Geometry::toMap(events[e].p.y))))
+            {
+                DoomMapIntersections_Swap s = swaps.top();
+                swaps.pop();
+                doSwap(s);
+                continue;
+            }
+
+            p = events[e].p;
+            starts.clear();
+            ends.clear();
+            for (; e < events.size() && events[e].p == p; e++)
+            {
+                if (events[e].start) starts.append(events[e].line);
+                else ends.append(events[e].line);
+            }
+
+            doPoint(starts, ends);
+        }
+    }
+};
+
+bool DoomMapIntersections_StatusLess::operator()(int a, int b) const
+{
+    if (a == b)
+        return false;
+    // -1 is the event point itself
+    if (a < 0)
+        return DoomMapIntersections_Orient(sweep->lines[b], sweep->p) < 0;
+    if (b < 0)
+        return DoomMapIntersections_Orient(sweep->lines[a], sweep->p) > 0;
+    // one of them is the line being inserted, which goes through the event point
+    if (sweep->contains(a))
+        return sweep->below(a, b);
+    return !sweep->below(b, a);
+}
+
+DoomMapIntersections::DoomMapIntersections()
+{
+
+}
+
+void DoomMapIntersections::clear()
+{
+    intersections.clear();
+    brokenSectors.clear();
+}
+
+void DoomMapIntersections::build(DoomMap* map)
+{
+    clear();
+
+    DoomMapIntersections_Sweep sweep;
+    sweep.out = &intersections;
+    sweep.lines.reserve(map->linedefs.size());
+    for (int i = 0; i < map->linedefs.size(); i++)
+    {
+        const DoomMapLinedef& linedef = map->linedefs[i];
+        if (linedef.v1 < 0 || linedef.v1 >= map->vertices.size() ||
+            linedef.v2 < 0 || linedef.v2 >= map->vertices.size())
+            continue;
+
+        FixedPoint v1 = Geometry::toFixed(map->vertices[linedef.v1].x, map->vertices[linedef.v1].y);
+        FixedPoint v2 = Geometry::toFixed(map->vertices[linedef.v2].x, map->vertices[linedef.v2].y);
+        if (v1 == v2)
+            continue;
+
+        DoomMapIntersections_Line l;
+        l.linedef = i;
+        l.v1 = DoomMapIntersections_PointLess(v1, v2) ? v1 : v2;
+        l.v2 = DoomMapIntersections_PointLess(v1, v2) ? v2 : v1;
+
+        sweep.lines.append(l);
+    }
+
+    sweep.run();
+
+    // sectors that have both lines of a crossing
+    brokenSectors.resize(map->sectors.size());
+    for (int i = 0; i < intersections.size(); i++)
+    {
+        const DoomMapIntersection& in = intersections[i];
+        if (in.type != DoomMapIntersection::Crossing)
+            continue;
+
+        int sectors[2][2];
+        int linedefs[2] = { in.linedef1, in.linedef2 };
+        for (int j = 0; j < 2; j++)
+        {
+            const DoomMapLinedef& linedef = map->linedefs[linedefs[j]];
+            int sidedefs[2] = { linedef.sidefront, linedef.sideback };
+            for (int k = 0; k < 2; k++)
+            {
+                int sd = sidedefs[k];
+                sectors[j][k] = (sd >= 0 && sd < map->sidedefs.size()) ? map->sidedefs[sd].sector : -1;
+            }
+        }
+
+        for (int j = 0; j < 2; j++)
+        {
+            int sector = sectors[0][j];
+            if (sector < 0 || sector >= brokenSectors.size())
+                continue;
+            if (sector == sectors[1][0] || sector == sectors[1][1])
+                brokenSectors.setBit(sector);
+        }
+    }
+}
+
+int DoomMapIntersections::getCount(DoomMapIntersection::Type type) const
+{
+    int count = 0;
+    for (int i = 0; i < intersections.size(); i++)
+    {
+        if (intersections[i].type == type)
+            count++;
+    }
+
+    return count;
+}
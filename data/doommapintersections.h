@@ -0,0 +1,52 @@
+#ifndef DOOMMAPINTERSECTIONS_H
+#define DOOMMAPINTERSECTIONS_H
+
+#include <QVector>
+#include <QPointF>
+#include <QBitArray>
+
+class DoomMap;
+
+// two linedefs that meet somewhere else than at a shared vertex.
+struct DoomMapIntersection
+{
+    enum Type
+    {
+        Crossing, // lines cross in the middle of both
+        Overlap, // lines lie on top of each other for some length
+        Touch // end of one line is in the middle of the other
+    };
+
+    int linedef1;
+    int linedef2;
+    Type type;
+    QPointF point; // crossing point, start of the overlap or the touching end
+};
+
+// finds crossing, overlapping and touching linedefs of the whole map.
+// this is a sweep line (Bentley-Ottmann), so it's O((n + k) log n) for n lines and k intersections, and can be redone after every edit.
+// vertex positions are rounded to the fixed point grid of geometry.h and compared with its exact orientation tests,
+// so lines meeting at the same position never count as crossing.
+class DoomMapIntersections
+{
+public:
+    DoomMapIntersections();
+
+    QVector<DoomMapIntersection> intersections;
+
+    void build(DoomMap* map);
+    void clear();
+
+    int getCount(DoomMapIntersection::Type type) const;
+
+    // sector has two lines of its own that cross each other. its outline is not a polygon, so it can't be triangulated.
+    bool isSectorBroken(int sector) const
+    {
+        return sector >= 0 && sector < brokenSectors.size() && brokenSectors.testBit(sector);
+    }
+
+private:
+    QBitArray brokenSectors;
+};
+
+#endif // DOOMMAPINTERSECTIONS_H
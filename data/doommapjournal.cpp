@@ -0,0 +1,173 @@
+#include "doommapjournal.h"
+
+DoomMapJournal::DoomMapJournal()
+{
+    position = 0;
+    depth = 0;
+    actionOpen = false;
+    size = 0;
+    maxSize = 64*1024*1024;
+}
+
+void DoomMapJournal::beginAction(const QString& name)
+{
+    if (depth++ == 0)
+        actionName = name;
+}
+
+void DoomMapJournal::endAction()
+{
+    if (depth <= 0)
+        return;
+
+    if (--depth == 0 && actionOpen)
+        closeAction();
+}
+
+void DoomMapJournal::openAction()
+{
+    truncateRedo();
+
+    DoomMapJournalAction action;
+    action.name = actionName;
+    action.firstDelta = deltas.size();
+    action.numDeltas = 0;
+    action.weld = -1;
+    action.size = sizeof(DoomMapJournalAction);
+    actions.append(action);
+    size += action.size;
+    position = actions.size();
+    actionOpen = true;
+}
+
+void DoomMapJournal::closeAction()
+{
+    actionOpen = false;
+    trim();
+}
+
+void DoomMapJournal::record(const DoomMapDelta& delta)
+{
+    if (depth == 0)
+    {
+        beginAction(QString());
+        record(delta);
+        endAction();
+        return;
+    }
+
+    if (!actionOpen)
+        openAction();
+
+    deltas.append(delta);
+    DoomMapJournalAction& action = actions.last();
+    action.numDeltas++;
+    action.size += sizeof(DoomMapDelta);
+    size += sizeof(DoomMapDelta);
+}
+
+void DoomMapJournal::recordWeld(const DoomMapWeld& weld)
+{
+    // deltas before the weld are one action, the weld is another, and deltas after it start a third one.
+    if (actionOpen)
+        closeAction();
+    truncateRedo();
+
+    DoomMapJournalAction action;
+    action.name = (depth > 0) ? actionName : QString();
+    action.firstDelta = deltas.size();
+    action.numDeltas = 0;
+    action.weld = welds.size();
+    action.size = sizeof(DoomMapJournalAction) + weld.getSize();
+    welds.append(weld);
+    actions.append(action);
+    size += action.size;
+    position = actions.size();
+    trim();
+}
+
+const DoomMapJournalAction* DoomMapJournal::takeUndo()
+{
+    if (!canUndo())
+        return 0;
+    position--;
+    return &actions[position];
+}
+
+const DoomMapJournalAction* DoomMapJournal::takeRedo()
+{
+    if (!canRedo())
+        return 0;
+    position++;
+    return &actions[position-1];
+}
+
+// a new edit after undo throws away what could be redone
+void DoomMapJournal::truncateRedo()
+{
+    if (position >= actions.size())
+        return;
+
+    int firstWeld = welds.size();
+    for (int i = position; i < actions.size(); i++)
+    {
+        size -= actions[i].size;
+        if (actions[i].weld >= 0 && actions[i].weld < firstWeld)
+            firstWeld = actions[i].weld;
+    }
+
+    deltas.resize(actions[position].firstDelta);
+    welds.resize(firstWeld);
+    actions.resize(position);
+}
+
+void DoomMapJournal::trim()
+{
+    if (size <= maxSize)
+        return;
+
+    // drop the oldest done actions until there's some room again, so this doesn't happen on every edit.
+    // the action that's still open is never dropped.
+    int limit = position - (actionOpen ? 1 : 0);
+    int count = 0;
+    int numWelds = 0;
+    while (count < limit && size > maxSize / 4 * 3)
+    {
+        size -= actions[count].size;
+        if (actions[count].weld >= 0)
+            numWelds++;
+        count++;
+    }
+
+    if (!count)
+        return;
+
+    int numDeltas = (count < actions.size()) ? actions[count].firstDelta : deltas.size();
+    deltas.remove(0, numDeltas);
+    welds.remove(0, numWelds);
+    actions.remove(0, count);
+    for (int i = 0; i < actions.size(); i++)
+    {
+        actions[i].firstDelta -= numDeltas;
+        if (actions[i].weld >= 0)
+            actions[i].weld -= numWelds;
+    }
+
+    position -= count;
+}
+
+void DoomMapJournal::setMaxSize(qint64 bytes)
+{
+    maxSize = bytes;
+    trim();
+}
+
+void DoomMapJournal::clear()
+{
+    actions.clear();
+    deltas.clear();
+    welds.clear();
+    position = 0;
+    actionOpen = false;
+    size = 0;
+}
@@ -0,0 +1,124 @@
+#ifndef DOOMMAPJOURNAL_H
+#define DOOMMAPJOURNAL_H
+
+#include <QVector>
+#include <QString>
+#include <cstring>
+#include "doommap.h"
+
+// one changed field of one component. values are raw 32-bit words (floats are bit copied), so all deltas have the same small size.
+struct DoomMapDelta
+{
+    enum Field
+    {
+        VertexPosition, // x, y
+        LinedefVertices, // v1, v2
+        LinedefSidedefs, // front, back
+        SidedefSector, // sector
+        SidedefTexture, // texture, part
+        SectorTexture, // texture, plane
+        SectorTag, // tag
+        LinedefId, // id
+        ThingId // id
+    };
+
+    int field;
+    int index;
+    qint32 before[2];
+    qint32 after[2];
+
+    static qint32 fromFloat(float f) { qint32 i; memcpy(&i, &f, 4); return i; }
+    static float toFloat(qint32 i) { float f; memcpy(&f, &i, 4); return f; }
+};
+
+// extra field of a component that a weld removed
+struct DoomMapWeldProperty
+{
+    int index;
+    int key;
+    QVariant value;
+};
+
+// what a weld removed and changed, in the numbering from before the weld. vertices and linedefs that aren't listed keep their order,
+// so the renumbering can be computed from the removed indices, and undo/redo only touch the listed components and the sectors around them.
+struct DoomMapWeld
+{
+    QVector<int> vertices; // removed, ascending
+    QVector<int> targets; // vertex each removed one was merged into
+    QVector<DoomMapVertex> vertexData;
+    QVector<int> linedefs; // removed (zero length or merged into another line), ascending
+    QVector<DoomMapLinedef> linedefData;
+    QVector<int> changed; // linedefs that stay but got other vertices, sides or special
+    QVector<DoomMapLinedef> changedBefore;
+    QVector<DoomMapLinedef> changedAfter; // vertices are still in the numbering from before
+    QVector<DoomMapWeldProperty> vertexProperties;
+    QVector<DoomMapWeldProperty> linedefProperties;
+
+    qint64 getSize() const
+    {
+        return vertices.size() * (2*sizeof(int) + sizeof(DoomMapVertex)) + linedefs.size() * (sizeof(int) + sizeof(DoomMapLinedef)) +
+               changed.size() * (sizeof(int) + 2*sizeof(DoomMapLinedef)) +
+               (vertexProperties.size() + linedefProperties.size()) * sizeof(DoomMapWeldProperty);
+    }
+};
+
+struct DoomMapJournalAction
+{
+    QString name;
+    int firstDelta;
+    int numDeltas;
+    int weld; // index in welds, -1 if none
+    qint64 size; // bytes, for the memory limit
+};
+
+// undo/redo history of one map. edits record what they changed, and undo/redo apply it back, so they cost as much as the edit itself.
+// the oldest actions are dropped when the history gets larger than the limit.
+class DoomMapJournal
+{
+public:
+    DoomMapJournal();
+
+    // edits between these are undone together. calls can be nested, the outermost pair makes the action.
+    // edits outside of any action are recorded as actions of their own.
+    void beginAction(const QString& name);
+    void endAction();
+    bool isInAction() const { return depth > 0; }
+
+    void record(const DoomMapDelta& delta);
+    // a weld always gets an action of its own. if an action is open, it's split around the weld.
+    void recordWeld(const DoomMapWeld& weld);
+
+    bool canUndo() const { return position > 0 && depth == 0; }
+    bool canRedo() const { return position < actions.size() && depth == 0; }
+    QString getUndoName() const { return canUndo() ? actions[position-1].name : QString(); }
+    QString getRedoName() const { return canRedo() ? actions[position].name : QString(); }
+
+    // returns the action to undo or redo and moves past it, or 0 if there is none.
+    const DoomMapJournalAction* takeUndo();
+    const DoomMapJournalAction* takeRedo();
+
+    const DoomMapDelta& getDelta(int i) const { return deltas[i]; }
+    const DoomMapWeld& getWeld(int i) const { return welds[i]; }
+
+    void setMaxSize(qint64 bytes);
+    qint64 getSize() const { return size; }
+    void clear();
+
+private:
+    QVector<DoomMapJournalAction> actions;
+    QVector<DoomMapDelta> deltas;
+    QVector<DoomMapWeld> welds;
+    int position; // actions before this are done, the rest can be redone
+    int depth;
+    bool actionOpen; // last action takes new deltas
+    QString actionName;
+    qint64 size;
+    qint64 maxSize;
+
+    void openAction();
+    void closeAction();
+    void truncateRedo();
+    void trim();
+};
+
+#endif // DOOMMAPJOURNAL_H
@@ -0,0 +1,306 @@
+#include "doommapnodes.h"
+#include "doommap.h"
+#include <QDataStream>
+
+DoomMapNodes::DoomMapNodes()
+{
+    valid = false;
+}
+
+void DoomMapNodes::clear()
+{
+    vertices.clear();
+    segs.clear();
+    subsectors.clear();
+    nodes.clear();
+    valid = false;
+}
+
+bool DoomMapNodes::load(DoomMap* map, QIODevice* segs, QIODevice* ssectors, QIODevice* nodes)
+{
+    clear();
+
+    // extended/compressed nodes (XNOD, ZNOD...) are stored in NODES with a signature instead. not supported here.
+    QByteArray signature = nodes->peek(4);
+    if (signature == "XNOD" || signature == "ZNOD" || signature == "XGLN" || signature == "ZGLN" || signature == "XGL2" || signature == "ZGL2")
+        return false;
+
+    // seg vertices are the map vertices, split vertices are already in VERTEXES
+    vertices.reserve(map->vertices.size());
+    for (int i = 0; i < map->vertices.size(); i++)
+        vertices.append(QPointF(map->vertices[i].x, map->vertices[i].y));
+
+    // one seg = 12 bytes
+    int numsegs = segs->size() / 12;
+    QDataStream segs_stream(segs);
+    segs_stream.setByteOrder(QDataStream::LittleEndian);
+    this->segs.reserve(numsegs);
+    for (int i = 0; i < numsegs; i++)
+    {
+        quint16 v1;
+        quint16 v2;
+        qint16 angle;
+        quint16 linedef;
+        qint16 direction;
+        qint16 offset;
+        segs_stream >> v1 >> v2 >> angle >> linedef >> direction >> offset;
+        if (v1 >= vertices.size() || v2 >= vertices.size())
+        {
+            qDebug("DoomMapNodes: seg %d refers to invalid vertices", i);
+            clear();
+            return false;
+        }
+        DoomMapSeg seg;
+        seg.v1 = (int)v1;
+        seg.v2 = (int)v2;
+        seg.linedef = (linedef < map->linedefs.size()) ? (int)linedef : -1;
+        seg.side = direction ? 1 : 0;
+        seg.offset = offset;
+        seg.angle = (quint16)angle;
+        this->segs.append(seg);
+    }
+
+    // one subsector = 4 bytes
+    int numssectors = ssectors->size() / 4;
+    QDataStream ssectors_stream(ssectors);
+    ssectors_stream.setByteOrder(QDataStream::LittleEndian);
+    this->subsectors.reserve(numssectors);
+    for (int i = 0; i < numssectors; i++)
+    {
+        quint16 numsegs;
+        quint16 firstseg;
+        ssectors_stream >> numsegs >> firstseg;
+        DoomMapSubsector ss;
+        ss.firstseg = (int)firstseg;
+        ss.numsegs = (int)numsegs;
+        ss.sector = -1;
+        if (ss.firstseg+ss.numsegs > this->segs.size())
+        {
+            qDebug("DoomMapNodes: subsector %d refers to invalid segs", i);
+            clear();
+            return false;
+        }
+        this->subsectors.append(ss);
+    }
+
+    if (!this->subsectors.size())
+    {
+        clear();
+        return false;
+    }
+
+    // one node = 28 bytes
+    int numnodes = nodes->size() / 28;
+    QDataStream nodes_stream(nodes);
+    nodes_stream.setByteOrder(QDataStream::LittleEndian);
+    this->nodes.reserve(numnodes);
+    for (int i = 0; i < numnodes; i++)
+    {
+        qint16 x;
+        qint16 y;
+        qint16 dx;
+        qint16 dy;
+        qint16 bbox[2][4];
+        quint16 children[2];
+        nodes_stream >> x >> y >> dx >> dy;
+        for (int j = 0; j < 2; j++)
+        {
+            for (int k = 0; k < 4; k++)
+                nodes_stream >> bbox[j][k];
+        }
+        nodes_stream >> children[0] >> children[1];
+
+        DoomMapNode node;
+        node.x = x;
+        node.y = y;
+        node.dx = dx;
+        node.dy = dy;
+        for (int j = 0; j < 2; j++)
+        {
+            for (int k = 0; k < 4; k++)
+                node.bbox[j][k] = bbox[j][k];
+            node.zmin[j] = node.zmax[j] = 0;
+
+            // high bit means subsector
+            if (children[j] & 0x8000)
+            {
+                int ss = children[j] & 0x7FFF;
+                if (ss >= numssectors)
+                {
+                    qDebug("DoomMapNodes: node %d refers to invalid subsector %d", i, ss);
+                    clear();
+                    return false;
+                }
+                node.children[j] = ~ss;
+            }
+            else
+            {
+                // children always come before parents. this also guarantees there are no loops.
+                if (children[j] >= i)
+                {
+                    qDebug("DoomMapNodes: node %d refers to invalid node %d", i, children[j]);
+                    clear();
+                    return false;
+                }
+                node.children[j] = (int)children[j];
+            }
+        }
+
+        this->nodes.append(node);
+    }
+
+    update(map);
+    return true;
+}
+
+void DoomMapNodes::save(QIODevice* vertexes, QIODevice* segs, QIODevice* ssectors, QIODevice* nodes) const
+{
+    QDataStream vertexes_stream(vertexes);
+    vertexes_stream.setByteOrder(QDataStream::LittleEndian);
+    for (int i = 0; i < vertices.size(); i++)
+        vertexes_stream << (qint16)qRound(vertices[i].x()) << (qint16)qRound(vertices[i].y());
+
+    QDataStream segs_stream(segs);
+    segs_stream.setByteOrder(QDataStream::LittleEndian);
+    for (int i = 0; i < this->segs.size(); i++)
+    {
+        const DoomMapSeg& seg = this->segs[i];
+        segs_stream << (quint16)seg.v1 << (quint16)seg.v2 << (qint16)seg.angle << (quint16)seg.linedef << (qint16)seg.side << (qint16)seg.offset;
+    }
+
+    QDataStream ssectors_stream(ssectors);
+    ssectors_stream.setByteOrder(QDataStream::LittleEndian);
+    for (int i = 0; i < subsectors.size(); i++)
+        ssectors_stream << (quint16)subsectors[i].numsegs << (quint16)subsectors[i].firstseg;
+
+    QDataStream nodes_stream(nodes);
+    nodes_stream.setByteOrder(QDataStream::LittleEndian);
+    for (int i = 0; i < this->nodes.size(); i++)
+    {
+        const DoomMapNode& node = this->nodes[i];
+        nodes_stream << (qint16)node.x << (qint16)node.y << (qint16)node.dx << (qint16)node.dy;
+        for (int j = 0; j < 2; j++)
+        {
+            for (int k = 0; k < 4; k++)
+                nodes_stream << (qint16)node.bbox[j][k];
+        }
+        for (int j = 0; j < 2; j++)
+        {
+            int child = node.children[j];
+            nodes_stream << (quint16)((child < 0) ? ((~child) | 0x8000) : child);
+        }
+    }
+}
+
+static void DoomMapNodes_ChildHeights(DoomMap* map, QVector<DoomMapNode>& nodes, QVector<DoomMapSubsector>& subsectors, int child, float& zmin, float& zmax)
+{
+    if (child < 0)
+    {
+        int sector = subsectors[~child].sector;
+        if (sector < 0)
+        {
+            zmin = 32767;
+            zmax = -32768;
+            return;
+        }
+
+        zmin = map->sectors[sector].heightfloor;
+        zmax = map->sectors[sector].heightceiling;
+        return;
+    }
+
+    DoomMapNode& node = nodes[child];
+    for (int i = 0; i < 2; i++)
+        DoomMapNodes_ChildHeights(map, nodes, subsectors, node.children[i], node.zmin[i], node.zmax[i]);
+
+    zmin = qMin(node.zmin[0], node.zmin[1]);
+    zmax = qMax(node.zmax[0], node.zmax[1]);
+}
+
+void DoomMapNodes::update(DoomMap* map)
+{
+    // find sector of each subsector
+    for (int i = 0; i < subsectors.size(); i++)
+    {
+        DoomMapSubsector& ss = subsectors[i];
+        ss.sector = -1;
+        for (int j = ss.firstseg; j < ss.firstseg+ss.numsegs; j++)
+        {
+            DoomMapSeg& seg = segs[j];
+            if (seg.linedef < 0)
+                continue;
+
+            DoomMapLinedef& linedef = map->linedefs[seg.linedef];
+            DoomMapSidedef* side = seg.side ? linedef.getBack(map) : linedef.getFront(map);
+            if (!side || side->sector < 0 || side->sector >= map->sectors.size())
+                continue;
+
+            ss.sector = side->sector;
+            break;
+        }
+    }
+
+    // floor/ceiling ranges of the nodes
+    if (nodes.size())
+    {
+        float zmin, zmax;
+        DoomMapNodes_ChildHeights(map, nodes, subsectors, nodes.size()-1, zmin, zmax);
+    }
+
+    valid = true;
+}
+
+void DoomMapNodes::traverse(float x, float y, DoomMapNodesVisitor* visitor) const
+{
+    if (!valid)
+        return;
+
+    // map with single subsector has no nodes
+    if (!nodes.size())
+    {
+        visitor->visitSubsector(0);
+        return;
+    }
+
+    // root node is the last one.
+    // back child is pushed first, so that the whole front subtree is walked before it.
+    QVector<int> stack;
+    stack.reserve(64);
+    stack.append(nodes.size()-1);
+    while (stack.size())
+    {
+        int current = stack.takeLast();
+        if (current < 0)
+        {
+            visitor->visitSubsector(~current);
+            continue;
+        }
+
+        const DoomMapNode& node = nodes[current];
+        int front = pointOnBack(node, x, y) ? 1 : 0;
+        int back = front ^ 1;
+
+        if (visitor->checkBox(node.bbox[back], node.zmin[back], node.zmax[back]))
+            stack.append(node.children[back]);
+        if (visitor->checkBox(node.bbox[front], node.zmin[front], node.zmax[front]))
+            stack.append(node.children[front]);
+    }
+}
+
+int DoomMapNodes::subsectorAt(float x, float y) const
+{
+    if (!valid)
+        return -1;
+
+    if (!nodes.size())
+        return 0;
+
+    int current = nodes.size()-1;
+    while (current >= 0)
+    {
+        const DoomMapNode& node = nodes[current];
+        current = node.children[pointOnBack(node, x, y) ? 1 : 0];
+    }
+
+    return ~current;
+}
@@ -0,0 +1,97 @@
+#ifndef DOOMMAPNODES_H
+#define DOOMMAPNODES_H
+
+#include <QVector>
+#include <QIODevice>
+#include <QPointF>
+#include "geometry.h"
+
+class DoomMap;
+
+struct DoomMapSeg
+{
+    int v1;
+    int v2;
+    int linedef;
+    int side; // 0 = front of the linedef, 1 = back
+    int offset; // distance along the linedef from its start on this side
+    int angle; // binary angle, 0..65535
+};
+
+struct DoomMapSubsector
+{
+    int firstseg;
+    int numsegs;
+    int sector; // -1 if subsector has no valid segs
+};
+
+struct DoomMapNode
+{
+    // partition line
+    float x;
+    float y;
+    float dx;
+    float dy;
+
+    // bounding boxes of children: 0 = right (front), 1 = left (back).
+    // order is top, bottom, left, right, same as in the NODES lump.
+    float bbox[2][4];
+    // floor/ceiling range of children, computed on load. used for vertical culling.
+    float zmin[2];
+    float zmax[2];
+    // node index if >= 0, ~subsector index if < 0
+    int children[2];
+};
+
+// this is called by DoomMapNodes::traverse
+class DoomMapNodesVisitor
+{
+public:
+    virtual ~DoomMapNodesVisitor() {}
+
+    // return false to skip the whole subtree. bbox is top, bottom, left, right.
+    virtual bool checkBox(const float* bbox, float zmin, float zmax) = 0;
+    virtual void visitSubsector(int subsector) = 0;
+};
+
+class DoomMapNodes
+{
+public:
+    DoomMapNodes();
+
+    QVector<QPointF> vertices; // seg vertices. these are map vertices followed by the ones created by splits.
+    QVector<DoomMapSeg> segs;
+    QVector<DoomMapSubsector> subsectors;
+    QVector<DoomMapNode> nodes;
+
+    // loads classic (vanilla format) SEGS, SSECTORS and NODES lumps. returns false if nodes are missing or not in a supported format.
+    bool load(DoomMap* map, QIODevice* segs, QIODevice* ssectors, QIODevice* nodes);
+    // writes classic VERTEXES, SEGS, SSECTORS and NODES lumps.
+    void save(QIODevice* vertexes, QIODevice* segs, QIODevice* ssectors, QIODevice* nodes) const;
+    void clear();
+
+    // recomputes subsector sectors and node heights from the map. this also marks the nodes valid.
+    void update(DoomMap* map);
+    bool isValid() const { return valid; }
+    // called when the map geometry changes. nodes stay invalid until update() or a rebuild.
+    void invalidate() { valid = false; }
+
+    // walks subsectors front to back as seen from x/y (map coordinates).
+    void traverse(float x, float y, DoomMapNodesVisitor* visitor) const;
+
+    // returns subsector that contains x/y, or -1 if there are no nodes.
+    int subsectorAt(float x, float y) const;
+
+    // true if x/y is on the back (left) side of the node partition line.
+    // same test as R_PointOnSide, but in fixed point, so points right on the partition line always go the same way.
+    static bool pointOnBack(const DoomMapNode& node, float x, float y)
+    {
+        FixedPoint d = Geometry::toFixed(x, y) - Geometry::toFixed(node.x, node.y);
+        return Geometry::cross(Geometry::toFixed(node.dx, node.dy), d) >= 0;
+    }
+
+private:
+    bool valid;
+};
+
+#endif // DOOMMAPNODES_H
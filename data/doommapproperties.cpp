@@ -0,0 +1,226 @@
+#include "doommapproperties.h"
+
+static int DoomMapProperties_TypeOf(const QVariant& value)
+{
+    switch (value.type())
+    {
+    case QVariant::Bool:
+        return DoomMapProperties::Bool;
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+        return DoomMapProperties::Int;
+    case QVariant::Double:
+        return DoomMapProperties::Float;
+    default:
+        return DoomMapProperties::String;
+    }
+}
+
+DoomMapProperties::DoomMapProperties()
+{
+
+}
+
+void DoomMapProperties::clear()
+{
+    keyIds.clear();
+    keyNames.clear();
+    for (int i = 0; i < NumKinds; i++)
+        columns[i].clear();
+}
+
+int DoomMapProperties::intern(const QString& name)
+{
+    int key = keyIds.value(name, -1);
+    if (key >= 0)
+        return key;
+
+    key = keyNames.size();
+    keyNames.append(name);
+    keyIds.insert(name, key);
+    return key;
+}
+
+const DoomMapPropertyColumn* DoomMapProperties::getColumn(Kind kind, int key) const
+{
+    if (kind < 0 || kind >= NumKinds || key < 0 || key >= columns[kind].size())
+        return 0;
+    const DoomMapPropertyColumn& column = columns[kind][key];
+    return (column.type >= 0) ? &column : 0;
+}
+
+void DoomMapProperties::set(Kind kind, int index, int key, const QVariant& value)
+{
+    if (kind < 0 || kind >= NumKinds || key < 0 || key >= keyNames.size() || index < 0)
+        return;
+
+    if (!value.isValid())
+    {
+        remove(kind, index, key);
+        return;
+    }
+
+    QVector<DoomMapPropertyColumn>& kindColumns = columns[kind];
+    if (key >= kindColumns.size())
+        kindColumns.resize(key+1);
+
+    DoomMapPropertyColumn& column = kindColumns[key];
+    if (column.type < 0)
+        column.type = DoomMapProperties_TypeOf(value);
+
+    int row = column.rows.value(index, -1);
+    if (row < 0)
+    {
+        row = column.components.size();
+        column.rows.insert(index, row);
+        column.components.append(index);
+        switch (column.type)
+        {
+        case Bool:
+        case Int:
+            column.ints.append(0);
+            break;
+        case Float:
+            column.floats.append(0);
+            break;
+        default:
+            column.strings.append(QString());
+            break;
+        }
+    }
+
+    switch (column.type)
+    {
+    case Bool:
+        column.ints[row] = value.toBool();
+        break;
+    case Int:
+        column.ints[row] = value.toLongLong();
+        break;
+    case Float:
+        column.floats[row] = value.toDouble();
+        break;
+    default:
+        column.strings[row] = value.toString();
+        break;
+    }
+}
+
+QVariant DoomMapProperties::get(Kind kind, int index, int key) const
+{
+    const DoomMapPropertyColumn* column = getColumn(kind, key);
+    if (!column)
+        return QVariant();
+
+    int row = column->rows.value(index, -1);
+    if (row < 0)
+        return QVariant();
+
+    switch (column->type)
+    {
+    case Bool:
+        return QVariant(column->ints[row] != 0);
+    case Int:
+        return QVariant(column->ints[row]);
+    case Float:
+        return QVariant(column->floats[row]);
+    default:
+        return QVariant(column->strings[row]);
+    }
+}
+
+bool DoomMapProperties::has(Kind kind, int index, int key) const
+{
+    const DoomMapPropertyColumn* column = getColumn(kind, key);
+    return column && column->rows.contains(index);
+}
+
+// last row is moved into the removed one
+void DoomMapProperties::removeRow(DoomMapPropertyColumn& column, int row)
+{
+    int last = column.components.size()-1;
+    column.rows.remove(column.components[row]);
+    if (row != last)
+    {
+        column.components[row] = column.components[last];
+        column.rows.insert(column.components[row], row);
+    }
+
+    column.components.removeLast();
+    switch (column.type)
+    {
+    case Bool:
+    case Int:
+        column.ints[row] = column.ints[last];
+        column.ints.removeLast();
+        break;
+    case Float:
+        column.floats[row] = column.floats[last];
+        column.floats.removeLast();
+        break;
+    default:
+        column.strings[row] = column.strings[last];
+        column.strings.removeLast();
+        break;
+    }
+}
+
+void DoomMapProperties::remove(Kind kind, int index, int key)
+{
+    if (!getColumn(kind, key))
+        return;
+
+    DoomMapPropertyColumn& column = columns[kind][key];
+    int row = column.rows.value(index, -1);
+    if (row >= 0)
+        removeRow(column, row);
+}
+
+QVector<int> DoomMapProperties::getKeys(Kind kind, int index) const
+{
+    QVector<int> keys;
+    if (kind < 0 || kind >= NumKinds)
+        return keys;
+
+    for (int i = 0; i < columns[kind].size(); i++)
+    {
+        const DoomMapPropertyColumn& column = columns[kind][i];
+        if (column.type >= 0 && column.rows.contains(index))
+            keys.append(i);
+    }
+
+    return keys;
+}
+
+void DoomMapProperties::remap(Kind kind, const QVector<int>& newIndex)
+{
+    if (kind < 0 || kind >= NumKinds)
+        return;
+
+    for (int i = 0; i < columns[kind].size(); i++)
+    {
+        DoomMapPropertyColumn& column = columns[kind][i];
+        if (column.type < 0)
+            continue;
+
+        // removed components first, then renumber what's left
+        for (int row = 0; row < column.components.size(); row++)
+        {
+            int index = column.components[row];
+            if (index < 0 || index >= newIndex.size() || newIndex[index] < 0)
+            {
+                removeRow(column, row);
+                row--;
+            }
+        }
+
+        column.rows.clear();
+        for (int row = 0; row < column.components.size(); row++)
+        {
+            column.components[row] = newIndex[column.components[row]];
+            column.rows.insert(column.components[row], row);
+        }
+    }
+}
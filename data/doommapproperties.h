@@ -0,0 +1,80 @@
+#ifndef DOOMMAPPROPERTIES_H
+#define DOOMMAPPROPERTIES_H
+
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+
+// one key for one kind of component. rows only exist for components that have the key set.
+struct DoomMapPropertyColumn
+{
+    DoomMapPropertyColumn() { type = -1; }
+
+    int type; // DoomMapProperties::Type, -1 if unused
+    QHash<int, int> rows; // component index -> row
+    QVector<int> components; // row -> component index
+    QVector<qint64> ints; // Bool and Int
+    QVector<double> floats;
+    QVector<QString> strings;
+};
+
+// extra (mostly UDMF) fields of map components that don't have their own member.
+// key names are interned once per map, and every key has a typed column per component kind,
+// so components without extra fields cost nothing.
+class DoomMapProperties
+{
+public:
+    enum Kind
+    {
+        Vertex,
+        Linedef,
+        Sidedef,
+        Sector,
+        Thing,
+        NumKinds
+    };
+
+    // like in UDMF, a key has one type. values of other types are converted to it.
+    enum Type
+    {
+        Bool,
+        Int,
+        Float,
+        String
+    };
+
+    DoomMapProperties();
+
+    // returns key id for name, adding it if needed
+    int intern(const QString& name);
+    // -1 if no component ever had this key
+    int findKey(const QString& name) const { return keyIds.value(name, -1); }
+    QString getKeyName(int key) const { return keyNames.value(key); }
+    int getKeyCount() const { return keyNames.size(); }
+
+    void set(Kind kind, int index, int key, const QVariant& value);
+    void set(Kind kind, int index, const QString& name, const QVariant& value) { set(kind, index, intern(name), value); }
+    // invalid QVariant if not set
+    QVariant get(Kind kind, int index, int key) const;
+    QVariant get(Kind kind, int index, const QString& name) const { return get(kind, index, findKey(name)); }
+    bool has(Kind kind, int index, int key) const;
+    void remove(Kind kind, int index, int key);
+    // keys that are set on one component
+    QVector<int> getKeys(Kind kind, int index) const;
+
+    // components of one kind were renumbered. newIndex has the new index of every old one, or -1 if it was removed.
+    void remap(Kind kind, const QVector<int>& newIndex);
+    void clear();
+
+private:
+    QHash<QString, int> keyIds;
+    QStringList keyNames;
+    QVector<DoomMapPropertyColumn> columns[NumKinds];
+
+    const DoomMapPropertyColumn* getColumn(Kind kind, int key) const;
+    void removeRow(DoomMapPropertyColumn& column, int row);
+};
+
+#endif // DOOMMAPPROPERTIES_H
@@ -0,0 +1,85 @@
+#include "doommaptagindex.h"
+#include "doommap.h"
+
+DoomMapTagIndex::DoomMapTagIndex()
+{
+
+}
+
+void DoomMapTagIndex::clear()
+{
+    for (int i = 0; i < NumKinds; i++)
+    {
+        tags[i].clear();
+        rows[i].clear();
+    }
+}
+
+void DoomMapTagIndex::build(const DoomMap* map)
+{
+    clear();
+    rows[Sector].fill(-1, map->sectors.size());
+    rows[Linedef].fill(-1, map->linedefs.size());
+    rows[Thing].fill(-1, map->things.size());
+
+    for (int i = 0; i < map->sectors.size(); i++)
+        update(Sector, i, 0, map->sectors[i].id);
+    for (int i = 0; i < map->linedefs.size(); i++)
+        update(Linedef, i, 0, map->linedefs[i].id);
+    for (int i = 0; i < map->things.size(); i++)
+        update(Thing, i, 0, map->things.id[i]);
+}
+
+void DoomMapTagIndex::update(Kind kind, int index, int oldTag, int newTag)
+{
+    if (kind < 0 || kind >= NumKinds || index < 0 || oldTag == newTag)
+        return;
+
+    QVector<int>& kindRows = rows[kind];
+    while (kindRows.size() <= index)
+        kindRows.append(-1);
+
+    // last component of the old list is moved into the removed one
+    if (oldTag && kindRows[index] >= 0)
+    {
+        QHash< int, QVector<int> >::iterator it = tags[kind].find(oldTag);
+        if (it != tags[kind].end())
+        {
+            QVector<int>& list = it.value();
+            int row = kindRows[index];
+            int last = list.last();
+            list[row] = last;
+            kindRows[last] = row;
+            list.removeLast();
+            if (list.isEmpty())
+                tags[kind].erase(it);
+        }
+
+        kindRows[index] = -1;
+    }
+
+    if (newTag)
+    {
+        QVector<int>& list = tags[kind][newTag];
+        kindRows[index] = list.size();
+        list.append(index);
+    }
+}
+
+const QVector<int>& DoomMapTagIndex::get(Kind kind, int tag) const
+{
+    if (kind < 0 || kind >= NumKinds || !tag)
+        return noComponents;
+
+    QHash< int, QVector<int> >::const_iterator it = tags[kind].find(tag);
+    if (it == tags[kind].end())
+        return noComponents;
+    return it.value();
+}
+
+QVector<int> DoomMapTagIndex::getTags(Kind kind) const
+{
+    if (kind < 0 || kind >= NumKinds)
+        return QVector<int>();
+    return tags[kind].keys().toVector();
+}
@@ -0,0 +1,42 @@
+#ifndef DOOMMAPTAGINDEX_H
+#define DOOMMAPTAGINDEX_H
+
+#include <QVector>
+#include <QHash>
+
+class DoomMap;
+
+// tag -> sectors, linedefs and things that have it (sector tags, line ids and thing ids).
+// DoomMap updates this on every tag edit, so finding what a special acts on is O(result) instead of a scan over the whole map.
+class DoomMapTagIndex
+{
+public:
+    enum Kind
+    {
+        Sector,
+        Linedef,
+        Thing,
+        NumKinds
+    };
+
+    DoomMapTagIndex();
+
+    void build(const DoomMap* map);
+    void clear();
+
+    // one component changed from oldTag to newTag.
+    void update(Kind kind, int index, int oldTag, int newTag);
+
+    // components of one kind with this tag, in no particular order. tag 0 means no tag, so it never has any.
+    const QVector<int>& get(Kind kind, int tag) const;
+    // every tag that has at least one component of this kind.
+    QVector<int> getTags(Kind kind) const;
+
+private:
+    QHash< int, QVector<int> > tags[NumKinds];
+    // component -> position in the list of its tag, -1 if it has no tag
+    QVector<int> rows[NumKinds];
+    QVector<int> noComponents;
+};
+
+#endif // DOOMMAPTAGINDEX_H
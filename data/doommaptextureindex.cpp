@@ -0,0 +1,133 @@
+#include "doommaptextureindex.h"
+#include "doommap.h"
+
+DoomMapTextureIndex::DoomMapTextureIndex()
+{
+
+}
+
+void DoomMapTextureIndex::clear()
+{
+    users.clear();
+    sidedefRows.clear();
+    sectorRows.clear();
+}
+
+void DoomMapTextureIndex::build(const DoomMap* map)
+{
+    clear();
+    sidedefRows.fill(-1, map->sidedefs.size() * NumSidedefParts);
+    sectorRows.fill(-1, map->sectors.size() * NumSectorPlanes);
+
+    for (int i = 0; i < map->sidedefs.size(); i++)
+    {
+        const DoomMapSidedef& sidedef = map->sidedefs[i];
+        updateSidedef(i, Top, Tex_NoTextureId, sidedef.texturetop);
+        updateSidedef(i, Bottom, Tex_NoTextureId, sidedef.texturebottom);
+        updateSidedef(i, Middle, Tex_NoTextureId, sidedef.texturemiddle);
+    }
+
+    for (int i = 0; i < map->sectors.size(); i++)
+    {
+        const DoomMapSector& sector = map->sectors[i];
+        updateSector(i, Floor, Tex_NoTextureId, sector.texturefloor);
+        updateSector(i, Ceiling, Tex_NoTextureId, sector.textureceiling);
+    }
+}
+
+DoomMapTextureUsers* DoomMapTextureIndex::getUsers(int texture, bool create)
+{
+    if (texture <= Tex_NoTextureId)
+        return 0;
+    if (texture >= users.size())
+    {
+        if (!create)
+            return 0;
+        users.resize(texture+1);
+    }
+
+    return &users[texture];
+}
+
+void DoomMapTextureIndex::insert(QVector<int>& list, QVector<int>& rows, int surface)
+{
+    while (rows.size() <= surface)
+        rows.append(-1);
+    rows[surface] = list.size();
+    list.append(surface);
+}
+
+// last surface is moved into the removed one
+void DoomMapTextureIndex::remove(QVector<int>& list, QVector<int>& rows, int surface)
+{
+    if (surface >= rows.size() || rows[surface] < 0)
+        return;
+
+    int row = rows[surface];
+    int last = list.last();
+    list[row] = last;
+    rows[last] = row;
+    list.removeLast();
+    rows[surface] = -1;
+}
+
+void DoomMapTextureIndex::updateSidedef(int sidedef, int part, int oldTexture, int newTexture)
+{
+    if (oldTexture == newTexture)
+        return;
+
+    int surface = getSidedefSurface(sidedef, part);
+    DoomMapTextureUsers* from = getUsers(oldTexture, false);
+    if (from)
+        remove(from->sidedefs, sidedefRows, surface);
+    DoomMapTextureUsers* to = getUsers(newTexture, true);
+    if (to)
+        insert(to->sidedefs, sidedefRows, surface);
+}
+
+void DoomMapTextureIndex::updateSector(int sector, int plane, int oldTexture, int newTexture)
+{
+    if (oldTexture == newTexture)
+        return;
+
+    int surface = getSectorSurface(sector, plane);
+    DoomMapTextureUsers* from = getUsers(oldTexture, false);
+    if (from)
+        remove(from->sectors, sectorRows, surface);
+    DoomMapTextureUsers* to = getUsers(newTexture, true);
+    if (to)
+        insert(to->sectors, sectorRows, surface);
+}
+
+const QVector<int>& DoomMapTextureIndex::getSidedefSurfaces(int texture) const
+{
+    if (texture <= Tex_NoTextureId || texture >= users.size())
+        return noSurfaces;
+    return users[texture].sidedefs;
+}
+
+const QVector<int>& DoomMapTextureIndex::getSectorSurfaces(int texture) const
+{
+    if (texture <= Tex_NoTextureId || texture >= users.size())
+        return noSurfaces;
+    return users[texture].sectors;
+}
+
+int DoomMapTextureIndex::getUseCount(int texture) const
+{
+    if (texture <= Tex_NoTextureId || texture >= users.size())
+        return 0;
+    return users[texture].sidedefs.size() + users[texture].sectors.size();
+}
+
+QVector<int> DoomMapTextureIndex::getUsedTextures() const
+{
+    QVector<int> used;
+    for (int i = 0; i < users.size(); i++)
+    {
+        if (users[i].sidedefs.size() || users[i].sectors.size())
+            used.append(i);
+    }
+
+    return used;
+}
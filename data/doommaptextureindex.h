@@ -0,0 +1,71 @@
+#ifndef DOOMMAPTEXTUREINDEX_H
+#define DOOMMAPTEXTUREINDEX_H
+
+#include <QVector>
+
+class DoomMap;
+
+// surfaces that use one texture. surfaces are numbered per component, see DoomMapTextureIndex::getSidedefSurface.
+struct DoomMapTextureUsers
+{
+    QVector<int> sidedefs;
+    QVector<int> sectors;
+};
+
+// texture id -> every sidedef part and sector plane that uses it.
+// DoomMap updates this on every texture edit, so finding the users of a texture is O(result) instead of a scan over the whole map.
+class DoomMapTextureIndex
+{
+public:
+    enum SidedefPart
+    {
+        Top,
+        Bottom,
+        Middle,
+        NumSidedefParts
+    };
+
+    enum SectorPlane
+    {
+        Floor,
+        Ceiling,
+        NumSectorPlanes
+    };
+
+    DoomMapTextureIndex();
+
+    static int getSidedefSurface(int sidedef, int part) { return sidedef * NumSidedefParts + part; }
+    static int getSidedef(int surface) { return surface / NumSidedefParts; }
+    static int getSidedefPart(int surface) { return surface % NumSidedefParts; }
+    static int getSectorSurface(int sector, int plane) { return sector * NumSectorPlanes + plane; }
+    static int getSector(int surface) { return surface / NumSectorPlanes; }
+    static int getSectorPlane(int surface) { return surface % NumSectorPlanes; }
+
+    void build(const DoomMap* map);
+    void clear();
+
+    // one surface changed from oldTexture to newTexture.
+    void updateSidedef(int sidedef, int part, int oldTexture, int newTexture);
+    void updateSector(int sector, int plane, int oldTexture, int newTexture);
+
+    // surfaces with this texture, in no particular order. Tex_NoTextureId is not tracked, so it never has any.
+    const QVector<int>& getSidedefSurfaces(int texture) const;
+    const QVector<int>& getSectorSurfaces(int texture) const;
+    int getUseCount(int texture) const;
+    bool isUsed(int texture) const { return getUseCount(texture) > 0; }
+    // every texture that has at least one surface, for "used in map" lists.
+    QVector<int> getUsedTextures() const;
+
+private:
+    QVector<DoomMapTextureUsers> users;
+    // surface -> position in its texture's list, -1 if it has no texture
+    QVector<int> sidedefRows;
+    QVector<int> sectorRows;
+    QVector<int> noSurfaces;
+
+    static void insert(QVector<int>& list, QVector<int>& rows, int surface);
+    static void remove(QVector<int>& list, QVector<int>& rows, int surface);
+    DoomMapTextureUsers* getUsers(int texture, bool create);
+};
+
+#endif // DOOMMAPTEXTUREINDEX_H
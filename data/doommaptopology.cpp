@@ -0,0 +1,275 @@
+#include "doommaptopology.h"
+#include "doommap.h"
+#include <QHash>
+#include <algorithm>
+
+static quint64 DoomMapTopology_PositionKey(const FixedPoint& p)
+{
+    return ((quint64)(quint32)p.x << 32) | (quint32)p.y;
+}
+
+// sorts half-edges around a vertex counterclockwise, starting from +x.
+struct DoomMapTopology_AngleLess
+{
+    const DoomMapTopology* topology;
+
+    bool operator()(int a, int b) const
+    {
+        const FixedPoint& o = topology->positions[topology->edges[a].origin];
+        FixedPoint da = topology->positions[topology->getDest(a)] - o;
+        FixedPoint db = topology->positions[topology->getDest(b)] - o;
+        FixedPoint ref(1, 0);
+
+        if (Geometry::angleLess(ref, da, db))
+            return true;
+        if (Geometry::angleLess(ref, db, da))
+            return false;
+
+        // overlapping lines, keep order stable
+        return a < b;
+    }
+};
+
+DoomMapTopology::DoomMapTopology()
+{
+
+}
+
+void DoomMapTopology::clear()
+{
+    vertices.clear();
+    positions.clear();
+    mapVertices.clear();
+    vertexEdgeOffsets.clear();
+    vertexEdges.clear();
+    edges.clear();
+    loops.clear();
+    sectorLoopOffsets.clear();
+    sectorLoops.clear();
+}
+
+void DoomMapTopology::build(DoomMap* map)
+{
+    clear();
+    buildVertices(map);
+    buildEdges(map);
+    linkEdges();
+    buildLoops(map->sectors.size());
+}
+
+void DoomMapTopology::buildVertices(DoomMap* map)
+{
+    QHash<quint64, int> keys;
+    keys.reserve(map->vertices.size());
+    mapVertices.fill(-1, map->vertices.size());
+    for (int i = 0; i < map->vertices.size(); i++)
+    {
+        const DoomMapVertex& v = map->vertices[i];
+        FixedPoint p = Geometry::toFixed(v.x, v.y);
+        quint64 key = DoomMapTopology_PositionKey(p);
+        int index = keys.value(key, -1);
+        if (index < 0)
+        {
+            index = vertices.size();
+            vertices.append(QPointF(v.x, v.y));
+            positions.append(p);
+            keys.insert(key, index);
+        }
+
+        mapVertices[i] = index;
+    }
+}
+
+void DoomMapTopology::buildEdges(DoomMap* map)
+{
+    edges.resize(map->linedefs.size()*2);
+    for (int i = 0; i < map->linedefs.size(); i++)
+    {
+        const DoomMapLinedef& linedef = map->linedefs[i];
+        int v1 = (linedef.v1 >= 0 && linedef.v1 < mapVertices.size()) ? mapVertices[linedef.v1] : -1;
+        int v2 = (linedef.v2 >= 0 && linedef.v2 < mapVertices.size()) ? mapVertices[linedef.v2] : -1;
+        if (v1 < 0 || v2 < 0 || v1 == v2)
+            v1 = v2 = -1; // broken or zero length, not part of any loop
+
+        int sidedefs[2] = { linedef.sidefront, linedef.sideback };
+        for (int side = 0; side < 2; side++)
+        {
+            DoomMapHalfEdge& edge = edges[getEdge(i, side)];
+            edge.origin = side ? v2 : v1;
+            edge.next = edge.prev = -1;
+            edge.linedef = i;
+            edge.side = side;
+            edge.loop = -1;
+
+            int sd = sidedefs[side];
+            int sector = (sd >= 0 && sd < map->sidedefs.size()) ? map->sidedefs[sd].sector : -1;
+            edge.sector = (sector >= 0 && sector < map->sectors.size()) ? sector : -1;
+        }
+    }
+}
+
+void DoomMapTopology::linkEdges()
+{
+    // group outgoing half-edges by vertex
+    vertexEdgeOffsets.fill(0, vertices.size()+1);
+    for (int i = 0; i < edges.size(); i++)
+    {
+        if (edges[i].origin >= 0)
+            vertexEdgeOffsets[edges[i].origin+1]++;
+    }
+
+    for (int i = 0; i < vertices.size(); i++)
+        vertexEdgeOffsets[i+1] += vertexEdgeOffsets[i];
+
+    vertexEdges.resize(vertexEdgeOffsets[vertices.size()]);
+    QVector<int> cursor = vertexEdgeOffsets;
+    for (int i = 0; i < edges.size(); i++)
+    {
+        if (edges[i].origin >= 0)
+            vertexEdges[cursor[edges[i].origin]++] = i;
+    }
+
+    DoomMapTopology_AngleLess less;
+    less.topology = this;
+    for (int i = 0; i < vertices.size(); i++)
+        std::sort(vertexEdges.begin()+vertexEdgeOffsets[i], vertexEdges.begin()+vertexEdgeOffsets[i+1], less);
+
+    // position of every half-edge around its origin
+    QVector<int> order(edges.size(), -1);
+    for (int i = 0; i < vertexEdges.size(); i++)
+        order[vertexEdges[i]] = i;
+
+    // the face is on the right, so the next half-edge is the first one counterclockwise from the twin.
+    for (int i = 0; i < edges.size(); i++)
+    {
+        if (edges[i].origin < 0)
+            continue;
+
+        int v = getDest(i);
+        int first = vertexEdgeOffsets[v];
+        int count = vertexEdgeOffsets[v+1] - first;
+        int slot = order[getTwin(i)] - first;
+        int next = vertexEdges[first + (slot+1) % count];
+        edges[i].next = next;
+        edges[next].prev = i;
+    }
+}
+
+void DoomMapTopology::buildLoops(int numsectors)
+{
+    for (int i = 0; i < edges.size(); i++)
+    {
+        if (edges[i].origin < 0 || edges[i].loop >= 0)
+            continue;
+
+        DoomMapLoop loop;
+        loop.first = i;
+        loop.count = 0;
+        loop.sector = -1;
+        loop.mixed = false;
+        loop.area = 0;
+
+        int e = i;
+        do
+        {
+            DoomMapHalfEdge& edge = edges[e];
+            edge.loop = loops.size();
+            loop.count++;
+
+            if (loop.count == 1) loop.sector = edge.sector;
+            else if (edge.sector != loop.sector) loop.mixed = true;
+
+            const QPointF& p1 = vertices[edge.origin];
+            const QPointF& p2 = vertices[getDest(e)];
+            loop.area += (p1.x() * p2.y() - p2.x() * p1.y()) / 2;
+
+            e = edge.next;
+        }
+        while (e != i);
+
+        // this is only needed for the mixed loops that start in the void
+        if (loop.sector < 0 && loop.mixed)
+        {
+            e = i;
+            do
+            {
+                if (edges[e].sector >= 0)
+                {
+                    loop.sector = edges[e].sector;
+                    break;
+                }
+                e = edges[e].next;
+            }
+            while (e != i);
+        }
+
+        loops.append(loop);
+    }
+
+    sectorLoopOffsets.fill(0, numsectors+1);
+    for (int i = 0; i < loops.size(); i++)
+    {
+        if (loops[i].sector >= 0)
+            sectorLoopOffsets[loops[i].sector+1]++;
+    }
+
+    for (int i = 0; i < numsectors; i++)
+        sectorLoopOffsets[i+1] += sectorLoopOffsets[i];
+
+    sectorLoops.resize(sectorLoopOffsets[numsectors]);
+    QVector<int> cursor = sectorLoopOffsets;
+    for (int i = 0; i < loops.size(); i++)
+    {
+        if (loops[i].sector >= 0)
+            sectorLoops[cursor[loops[i].sector]++] = i;
+    }
+}
+
+QPolygonF DoomMapTopology::getLoopPolygon(int loop) const
+{
+    QPolygonF poly;
+    const DoomMapLoop& l = loops[loop];
+    poly.reserve(l.count);
+    int e = l.first;
+    for (int i = 0; i < l.count; i++)
+    {
+        poly.append(vertices[edges[e].origin]);
+        e = edges[e].next;
+    }
+
+    return poly;
+}
+
+bool DoomMapTopology::loopContains(int loop, float x, float y) const
+{
+    bool inside = false;
+    const DoomMapLoop& l = loops[loop];
+    int e = l.first;
+    for (int i = 0; i < l.count; i++)
+    {
+        const QPointF& p1 = vertices[edges[e].origin];
+        const QPointF& p2 = vertices[getDest(e)];
+        if ((p1.y() > y) != (p2.y() > y))
+        {
+            double cx = p1.x() + (y - p1.y()) * (p2.x() - p1.x()) / (p2.y() - p1.y());
+            if (x < cx)
+                inside = !inside;
+        }
+
+        e = edges[e].next;
+    }
+
+    return inside;
+}
+
+int DoomMapTopology::getMixedLoopCount() const
+{
+    int count = 0;
+    for (int i = 0; i < loops.size(); i++)
+    {
+        if (loops[i].mixed)
+            count++;
+    }
+
+    return count;
+}
@@ -0,0 +1,85 @@
+#ifndef DOOMMAPTOPOLOGY_H
+#define DOOMMAPTOPOLOGY_H
+
+#include <QVector>
+#include <QPointF>
+#include <QPolygonF>
+#include "geometry.h"
+
+class DoomMap;
+
+// one side of a linedef. the face (sector) is on the right side, same as with linedef front sides.
+struct DoomMapHalfEdge
+{
+    int origin; // topology vertex, -1 if the linedef is broken or zero length
+    int next; // next half-edge around the face
+    int prev;
+    int linedef;
+    int side; // 0 = front (v1 to v2), 1 = back (v2 to v1)
+    int sector; // -1 if there's no sidedef on this side
+    int loop;
+};
+
+// closed chain of half-edges.
+struct DoomMapLoop
+{
+    int first; // any half-edge of the loop
+    int count;
+    int sector; // sector of the first half-edge
+    bool mixed; // half-edges belong to different sectors. this means the sector is not closed.
+    double area; // signed. < 0 for outer boundaries, > 0 for boundaries around holes.
+};
+
+// half-edge (DCEL) structure of the whole map.
+// vertices at the same fixed point position (see geometry.h) are merged, so loops don't depend on how the lines were drawn.
+// it's built in linear time (plus sorting lines around every vertex), so edits can just rebuild it.
+class DoomMapTopology
+{
+public:
+    DoomMapTopology();
+
+    QVector<QPointF> vertices; // unique positions
+    QVector<FixedPoint> positions; // same in fixed point, for the exact ordering of edges around vertices
+    QVector<int> mapVertices; // topology vertex for every map vertex, -1 if unused
+    // half-edges going out of every vertex, counterclockwise. edges of vertex i are vertexEdges[vertexEdgeOffsets[i]] up to vertexEdgeOffsets[i+1].
+    QVector<int> vertexEdgeOffsets;
+    QVector<int> vertexEdges;
+
+    QVector<DoomMapHalfEdge> edges; // 2 per linedef, see getEdge
+    QVector<DoomMapLoop> loops;
+
+    // loops of every sector, same layout as vertexEdges.
+    QVector<int> sectorLoopOffsets;
+    QVector<int> sectorLoops;
+
+    void build(DoomMap* map);
+    void clear();
+
+    static int getEdge(int linedef, int side) { return linedef*2+side; }
+    static int getTwin(int edge) { return edge ^ 1; }
+    int getDest(int edge) const { return edges[edge^1].origin; }
+
+    int getLoopCount(int sector) const
+    {
+        if (sector < 0 || sector+1 >= sectorLoopOffsets.size())
+            return 0;
+        return sectorLoopOffsets[sector+1] - sectorLoopOffsets[sector];
+    }
+
+    int getLoop(int sector, int i) const { return sectorLoops[sectorLoopOffsets[sector]+i]; }
+
+    QPolygonF getLoopPolygon(int loop) const;
+    // even-odd test against one loop
+    bool loopContains(int loop, float x, float y) const;
+
+    // number of loops that have more than one sector
+    int getMixedLoopCount() const;
+
+private:
+    void buildVertices(DoomMap* map);
+    void buildEdges(DoomMap* map);
+    void linkEdges();
+    void buildLoops(int numsectors);
+};
+
+#endif // DOOMMAPTOPOLOGY_H
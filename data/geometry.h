@@ -0,0 +1,103 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <QtGlobal>
+#include <QPointF>
+
+// map position in 24.8 fixed point.
+// classic maps have integer coordinates, and UDMF maps very rarely need more than 1/256 of a unit.
+struct FixedPoint
+{
+    qint64 x;
+    qint64 y;
+
+    FixedPoint() : x(0), y(0) {}
+    FixedPoint(qint64 x, qint64 y) : x(x), y(y) {}
+
+    bool operator==(const FixedPoint& other) const { return x == other.x && y == other.y; }
+    bool operator!=(const FixedPoint& other) const { return x != other.x || y != other.y; }
+    FixedPoint operator-(const FixedPoint& other) const { return FixedPoint(x - other.x, y - other.y); }
+    FixedPoint operator+(const FixedPoint& other) const { return FixedPoint(x + other.x, y + other.y); }
+};
+
+// exact geometry predicates on fixed point positions. no trig, no epsilons.
+// coordinates up to +-2^21 units (much more than any port allows) keep every product here inside 64 bits.
+// y goes up, like in map coordinates, so positive orientation is counterclockwise.
+class Geometry
+{
+public:
+    static const int FracBits = 8;
+    static const qint64 One = 1 << FracBits;
+
+    static qint64 toFixed(double v) { return qRound64(v * One); }
+    static FixedPoint toFixed(double x, double y) { return FixedPoint(toFixed(x), toFixed(y)); }
+    static FixedPoint toFixed(const QPointF& p) { return FixedPoint(toFixed(p.x()), toFixed(p.y())); }
+    static double toMap(qint64 v) { return (double)v / One; }
+    static QPointF toMap(const FixedPoint& p) { return QPointF(toMap(p.x), toMap(p.y)); }
+
+    static qint64 cross(const FixedPoint& a, const FixedPoint& b) { return a.x * b.y - a.y * b.x; }
+    static qint64 dot(const FixedPoint& a, const FixedPoint& b) { return a.x * b.x + a.y * b.y; }
+
+    // > 0 if c is left of a->b (counterclockwise), < 0 if right, 0 if on the line
+    static qint64 orient(const FixedPoint& a, const FixedPoint& b, const FixedPoint& c)
+    {
+        return cross(b - a, c - a);
+    }
+
+    static int sign(qint64 v) { return (v > 0) - (v < 0); }
+
+    // 0 for directions in [0, 180) degrees counterclockwise from ref, 1 for [180, 360)
+    static int half(const FixedPoint& ref, const FixedPoint& d)
+    {
+        qint64 c = cross(ref, d);
+        if (c != 0)
+            return c > 0 ? 0 : 1;
+        return dot(ref, d) >= 0 ? 0 : 1;
+    }
+
+    // counterclockwise angle from ref to a is smaller than from ref to b. angles are [0, 360), so a direction equal to ref comes first.
+    static bool angleLess(const FixedPoint& ref, const FixedPoint& a, const FixedPoint& b)
+    {
+        int ha = half(ref, a);
+        int hb = half(ref, b);
+        if (ha != hb)
+            return ha < hb;
+        return cross(a, b) > 0;
+    }
+
+    // p is on the closed segment a-b
+    static bool onSegment(const FixedPoint& a, const FixedPoint& b, const FixedPoint& p)
+    {
+        return orient(a, b, p) == 0 &&
+               p.x >= qMin(a.x, b.x) && p.x <= qMax(a.x, b.x) &&
+               p.y >= qMin(a.y, b.y) && p.y <= qMax(a.y, b.y);
+    }
+
+    // segments cross at a point inside both of them
+    static bool segmentsCross(const FixedPoint& a1, const FixedPoint& a2, const FixedPoint& b1, const FixedPoint& b2)
+    {
+        return sign(orient(a1, a2, b1)) * sign(orient(a1, a2, b2)) < 0 &&
+               sign(orient(b1, b2, a1)) * sign(orient(b1, b2, a2)) < 0;
+    }
+
+    // segments have at least one point in common, ends included
+    static bool segmentsIntersect(const FixedPoint& a1, const FixedPoint& a2, const FixedPoint& b1, const FixedPoint& b2)
+    {
+        if (segmentsCross(a1, a2, b1, b2))
+            return true;
+        return onSegment(a1, a2, b1) || onSegment(a1, a2, b2) || onSegment(b1, b2, a1) || onSegment(b1, b2, a2);
+    }
+
+    // p is inside triangle a, b, c or on its border. the triangle can go either way.
+    static bool pointInTriangle(const FixedPoint& a, const FixedPoint& b, const FixedPoint& c, const FixedPoint& p)
+    {
+        int s1 = sign(orient(a, b, p));
+        int s2 = sign(orient(b, c, p));
+        int s3 = sign(orient(c, a, p));
+        bool neg = s1 < 0 || s2 < 0 || s3 < 0;
+        bool pos = s1 > 0 || s2 > 0 || s3 > 0;
+        return !(neg && pos);
+    }
+};
+
+#endif // GEOMETRY_H
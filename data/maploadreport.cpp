@@ -0,0 +1,163 @@
+#include "maploadreport.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDir>
+#include <QFile>
+#if defined(MAPLOADREPORT_HEAP) && defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+qint64 MapLoadReport::getHeapUsed()
+{
+#if defined(MAPLOADREPORT_HEAP) && defined(__GLIBC__)
+    // walks the malloc arenas, so it's too slow to leave on in release builds
+#if __GLIBC_PREREQ(2, 33)
+    struct mallinfo2 mi = mallinfo2();
+    return (qint64)mi.uordblks + (qint64)mi.hblkhd;
+#else
+    struct mallinfo mi = mallinfo();
+    return (qint64)(unsigned int)mi.uordblks + (qint64)(unsigned int)mi.hblkhd;
+#endif
+#else
+    return -1;
+#endif
+}
+
+MapLoadReport::MapLoadReport()
+{
+    active = false;
+    bytesRead = 0;
+}
+
+MapLoadReport& MapLoadReport::get()
+{
+    static MapLoadReport report;
+    return report;
+}
+
+void MapLoadReport::reset(QString source)
+{
+    active = true;
+    this->source = source;
+    mapName.clear();
+    fileName.clear();
+    bytesRead = 0;
+    phases.clear();
+    counters.clear();
+}
+
+void MapLoadReport::setCounter(QString name, qint64 value)
+{
+    if (!active)
+        return;
+
+    for (int i = 0; i < counters.size(); i++)
+    {
+        if (counters[i].first == name)
+        {
+            counters[i].second = value;
+            return;
+        }
+    }
+
+    counters.append(QPair<QString, qint64>(name, value));
+}
+
+void MapLoadReport::addPhase(QString name, qint64 nsecs, qint64 heapBytes)
+{
+    if (!active)
+        return;
+
+    Phase phase;
+    phase.name = name;
+    phase.nsecs = nsecs;
+    phase.heapBytes = heapBytes;
+    phases.append(phase);
+}
+
+bool MapLoadReport::hasPhase(QString name) const
+{
+    for (int i = 0; i < phases.size(); i++)
+    {
+        if (phases[i].name == name)
+            return true;
+    }
+
+    return false;
+}
+
+QJsonObject MapLoadReport::toJson() const
+{
+    QJsonObject root;
+    root["source"] = source;
+    root["map"] = mapName;
+    root["date"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    root["build"] = QString(__DATE__) + " " + QString(__TIME__);
+    root["qt"] = QString(QT_VERSION_STR);
+    root["bytesRead"] = (double)bytesRead;
+
+    qint64 totalnsecs = 0;
+    QJsonArray jphases;
+    for (int i = 0; i < phases.size(); i++)
+    {
+        QJsonObject jphase;
+        jphase["name"] = phases[i].name;
+        jphase["ms"] = (double)phases[i].nsecs / 1000000;
+        if (phases[i].heapBytes >= 0)
+            jphase["heapBytes"] = (double)phases[i].heapBytes;
+        jphases.append(jphase);
+        totalnsecs += phases[i].nsecs;
+    }
+    root["phases"] = jphases;
+    root["totalMs"] = (double)totalnsecs / 1000000;
+
+    QJsonObject jcounters;
+    for (int i = 0; i < counters.size(); i++)
+        jcounters[counters[i].first] = (double)counters[i].second;
+    root["counters"] = jcounters;
+
+    return root;
+}
+
+QString MapLoadReport::getSummary() const
+{
+    qint64 totalnsecs = 0;
+    QString phasestr;
+    for (int i = 0; i < phases.size(); i++)
+    {
+        totalnsecs += phases[i].nsecs;
+        if (i) phasestr += ", ";
+        phasestr += phases[i].name + " " + QString::number((double)phases[i].nsecs / 1000000, 'f', 1) + "ms";
+    }
+
+    return QString("Loaded %1 in %2ms (%3)").arg(mapName).arg((double)totalnsecs / 1000000, 0, 'f', 1).arg(phasestr);
+}
+
+QString MapLoadReport::finish()
+{
+    if (!active)
+        return QString();
+
+    // same file is rewritten if more phases come later
+    if (fileName.isEmpty())
+    {
+        QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation));
+        dir.mkpath("loadreports");
+        QString base = QFileInfo(source).fileName() + "-" + mapName + "-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".json";
+        fileName = dir.filePath("loadreports/" + base);
+    }
+
+    QFile f(fileName);
+    if (f.open(QIODevice::WriteOnly))
+    {
+        f.write(QJsonDocument(toJson()).toJson());
+        f.close();
+        qDebug("MapLoadReport: written to %s", fileName.toUtf8().data());
+    }
+    else qDebug("MapLoadReport: can't write %s", fileName.toUtf8().data());
+
+    return getSummary();
+}
@@ -0,0 +1,80 @@
+#ifndef MAPLOADREPORT_H
+#define MAPLOADREPORT_H
+
+#include <QString>
+#include <QVector>
+#include <QPair>
+#include <QElapsedTimer>
+#include <QJsonObject>
+
+// timing and counters of the map loading process.
+// there is only one report at a time; it's reset when a WAD is opened and finished after the first 3D render.
+class MapLoadReport
+{
+public:
+    struct Phase
+    {
+        QString name;
+        qint64 nsecs;
+        qint64 heapBytes;
+    };
+
+    static MapLoadReport& get();
+
+    void reset(QString source);
+    void setMapName(QString name) { mapName = name; }
+
+    void setCounter(QString name, qint64 value);
+    void addBytesRead(qint64 bytes) { bytesRead += bytes; }
+
+    // phases are normally recorded with MapLoadPhase.
+    void addPhase(QString name, qint64 nsecs, qint64 heapBytes);
+    bool hasPhase(QString name) const;
+
+    // writes json and returns a one-line summary for status bar. can be called again if more phases were added.
+    QString finish();
+    bool isActive() const { return active; }
+
+    QJsonObject toJson() const;
+    QString getSummary() const;
+
+    // bytes in use on the malloc heap, or -1 if this build can't tell.
+    // only measured in debug builds on glibc (MAPLOADREPORT_HEAP in the .pro); phases then also report their heap growth.
+    static qint64 getHeapUsed();
+
+private:
+    MapLoadReport();
+
+    bool active;
+    QString source;
+    QString mapName;
+    QString fileName;
+    qint64 bytesRead;
+    QVector<Phase> phases;
+    QVector< QPair<QString, qint64> > counters;
+};
+
+// measures one load phase from construction to destruction.
+class MapLoadPhase
+{
+public:
+    MapLoadPhase(QString name)
+    {
+        this->name = name;
+        heapUsed = MapLoadReport::getHeapUsed();
+        timer.start();
+    }
+
+    ~MapLoadPhase()
+    {
+        qint64 nsecs = timer.nsecsElapsed();
+        MapLoadReport::get().addPhase(name, nsecs, (heapUsed >= 0) ? MapLoadReport::getHeapUsed()-heapUsed : -1);
+    }
+
+private:
+    QString name;
+    QElapsedTimer timer;
+    qint64 heapUsed;
+};
+
+#endif // MAPLOADREPORT_H
@@ -0,0 +1,346 @@
+#include "nodebuilder.h"
+#include "doommap.h"
+#include <QtConcurrent>
+#include <cmath>
+#include <climits>
+
+// past this many segs, not every seg is tried as a partition line.
+static const int NodeBuilder_MaxCandidates = 512;
+// don't spin up threads for tiny sets.
+static const int NodeBuilder_ParallelWork = 32768;
+
+// > 0 is front (right) side of the partition, < 0 is back (left), 0 is on the line. same convention as R_PointOnSide.
+static inline qint64 NodeBuilder_Side(const NodeBuilder::Vertex& p1, const NodeBuilder::Vertex& p2, const NodeBuilder::Vertex& v)
+{
+    return (qint64)(v.x - p1.x) * (p2.y - p1.y) - (qint64)(v.y - p1.y) * (p2.x - p1.x);
+}
+
+// 0 = front, 1 = back, 2 = needs split
+static inline int NodeBuilder_Classify(const QVector<NodeBuilder::Vertex>& vertices, const NodeBuilder::Seg& partition, const NodeBuilder::Seg& seg)
+{
+    const NodeBuilder::Vertex& p1 = vertices[partition.v1];
+    const NodeBuilder::Vertex& p2 = vertices[partition.v2];
+    qint64 sa = NodeBuilder_Side(p1, p2, vertices[seg.v1]);
+    qint64 sb = NodeBuilder_Side(p1, p2, vertices[seg.v2]);
+
+    if (sa == 0 && sb == 0)
+    {
+        // on the partition line. goes to front if it faces the same way.
+        const NodeBuilder::Vertex& v1 = vertices[seg.v1];
+        const NodeBuilder::Vertex& v2 = vertices[seg.v2];
+        qint64 dot = (qint64)(v2.x - v1.x) * (p2.x - p1.x) + (qint64)(v2.y - v1.y) * (p2.y - p1.y);
+        return (dot > 0) ? 0 : 1;
+    }
+
+    if (sa >= 0 && sb >= 0) return 0;
+    if (sa <= 0 && sb <= 0) return 1;
+    return 2;
+}
+
+struct NodeBuilder_Candidate
+{
+    int seg;
+    int front;
+    int back;
+    int splits;
+    int cost;
+};
+
+// evaluates one partition candidate. this runs on the thread pool.
+struct NodeBuilder_Evaluate
+{
+    typedef void result_type;
+
+    const QVector<NodeBuilder::Seg>* segs;
+    const QVector<NodeBuilder::Vertex>* vertices;
+
+    void operator()(NodeBuilder_Candidate& c) const
+    {
+        const NodeBuilder::Seg& partition = (*segs)[c.seg];
+        c.front = c.back = c.splits = 0;
+        for (int i = 0; i < segs->size(); i++)
+        {
+            switch (NodeBuilder_Classify(*vertices, partition, (*segs)[i]))
+            {
+            case 0: c.front++; break;
+            case 1: c.back++; break;
+            default: c.splits++; break;
+            }
+        }
+
+        // partition that doesn't divide anything is useless
+        if (!c.splits && (!c.front || !c.back))
+        {
+            c.cost = INT_MAX;
+            return;
+        }
+
+        c.cost = c.splits * 8 + qAbs(c.front - c.back);
+    }
+};
+
+NodeBuilder::NodeBuilder(DoomMap* map)
+{
+    this->map = map;
+    out = 0;
+}
+
+int NodeBuilder::addVertex(int x, int y)
+{
+    Vertex v;
+    v.x = x;
+    v.y = y;
+    vertices.append(v);
+    return vertices.size()-1;
+}
+
+void NodeBuilder::createSegs(QVector<Seg>& initial)
+{
+    for (int i = 0; i < map->linedefs.size(); i++)
+    {
+        DoomMapLinedef& linedef = map->linedefs[i];
+        if (linedef.v1 < 0 || linedef.v1 >= vertices.size() ||
+                linedef.v2 < 0 || linedef.v2 >= vertices.size())
+            continue;
+
+        Vertex& v1 = vertices[linedef.v1];
+        Vertex& v2 = vertices[linedef.v2];
+        if (v1.x == v2.x && v1.y == v2.y)
+            continue; // zero length
+
+        // BAM angle, upper 16 bits
+        int angle = (int)(atan2((double)(v2.y - v1.y), (double)(v2.x - v1.x)) * 32768 / M_PI) & 0xFFFF;
+
+        if (linedef.getFront(map))
+        {
+            Seg seg;
+            seg.v1 = linedef.v1;
+            seg.v2 = linedef.v2;
+            seg.linedef = i;
+            seg.side = 0;
+            seg.offset = 0;
+            seg.angle = angle;
+            initial.append(seg);
+        }
+
+        if (linedef.getBack(map))
+        {
+            Seg seg;
+            seg.v1 = linedef.v2;
+            seg.v2 = linedef.v1;
+            seg.linedef = i;
+            seg.side = 1;
+            seg.offset = 0;
+            seg.angle = (angle + 0x8000) & 0xFFFF;
+            initial.append(seg);
+        }
+    }
+}
+
+bool NodeBuilder::build(DoomMapNodes& out)
+{
+    this->out = &out;
+    out.clear();
+    vertices.clear();
+    segs.clear();
+
+    // classic nodes store integer vertices, so round fractional (udmf) coordinates.
+    vertices.reserve(map->vertices.size());
+    for (int i = 0; i < map->vertices.size(); i++)
+        addVertex(qRound(map->vertices[i].x), qRound(map->vertices[i].y));
+
+    QVector<Seg> initial;
+    createSegs(initial);
+    if (!initial.size())
+        return false;
+
+    float bbox[4];
+    int root = buildSubtree(initial, bbox);
+    // single subsector map has no nodes, subsector 0 is the root then.
+    Q_UNUSED(root);
+
+    out.vertices.resize(vertices.size());
+    for (int i = 0; i < vertices.size(); i++)
+        out.vertices[i] = QPointF(vertices[i].x, vertices[i].y);
+
+    out.segs.resize(segs.size());
+    for (int i = 0; i < segs.size(); i++)
+    {
+        DoomMapSeg& seg = out.segs[i];
+        seg.v1 = segs[i].v1;
+        seg.v2 = segs[i].v2;
+        seg.linedef = segs[i].linedef;
+        seg.side = segs[i].side;
+        seg.offset = segs[i].offset;
+        seg.angle = segs[i].angle;
+    }
+
+    out.update(map);
+    return true;
+}
+
+void NodeBuilder::getBoundingBox(const QVector<Seg>& segs, float* bbox)
+{
+    int top = INT_MIN;
+    int bottom = INT_MAX;
+    int left = INT_MAX;
+    int right = INT_MIN;
+    for (int i = 0; i < segs.size(); i++)
+    {
+        const Vertex& v1 = vertices[segs[i].v1];
+        const Vertex& v2 = vertices[segs[i].v2];
+        top = qMax(top, qMax(v1.y, v2.y));
+        bottom = qMin(bottom, qMin(v1.y, v2.y));
+        left = qMin(left, qMin(v1.x, v2.x));
+        right = qMax(right, qMax(v1.x, v2.x));
+    }
+
+    bbox[0] = top;
+    bbox[1] = bottom;
+    bbox[2] = left;
+    bbox[3] = right;
+}
+
+int NodeBuilder::pickPartition(const QVector<Seg>& segs, bool sampled)
+{
+    int stride = 1;
+    if (sampled && segs.size() > NodeBuilder_MaxCandidates)
+        stride = segs.size() / NodeBuilder_MaxCandidates;
+
+    QVector<NodeBuilder_Candidate> candidates;
+    candidates.reserve(segs.size() / stride + 1);
+    for (int i = 0; i < segs.size(); i += stride)
+    {
+        NodeBuilder_Candidate c;
+        c.seg = i;
+        c.front = c.back = c.splits = 0;
+        c.cost = INT_MAX;
+        candidates.append(c);
+    }
+
+    NodeBuilder_Evaluate evaluate;
+    evaluate.segs = &segs;
+    evaluate.vertices = &vertices;
+
+    if ((qint64)candidates.size() * segs.size() >= NodeBuilder_ParallelWork)
+    {
+        QtConcurrent::blockingMap(candidates, evaluate);
+    }
+    else
+    {
+        for (int i = 0; i < candidates.size(); i++)
+            evaluate(candidates[i]);
+    }
+
+    // candidates are in seg order, so ties always resolve the same way.
+    int best = -1;
+    int bestcost = INT_MAX;
+    for (int i = 0; i < candidates.size(); i++)
+    {
+        if (candidates[i].cost < bestcost)
+        {
+            best = candidates[i].seg;
+            bestcost = candidates[i].cost;
+        }
+    }
+
+    return best;
+}
+
+void NodeBuilder::splitSegs(const QVector<Seg>& segs, const Seg& partition, QVector<Seg>& front, QVector<Seg>& back)
+{
+    const Vertex p1 = vertices[partition.v1];
+    const Vertex p2 = vertices[partition.v2];
+
+    for (int i = 0; i < segs.size(); i++)
+    {
+        const Seg& seg = segs[i];
+        int side = NodeBuilder_Classify(vertices, partition, seg);
+        if (side == 0)
+        {
+            front.append(seg);
+            continue;
+        }
+        else if (side == 1)
+        {
+            back.append(seg);
+            continue;
+        }
+
+        // split at the intersection, rounded to integer
+        Vertex a = vertices[seg.v1];
+        Vertex b = vertices[seg.v2];
+        qint64 sa = NodeBuilder_Side(p1, p2, a);
+        qint64 sb = NodeBuilder_Side(p1, p2, b);
+        double t = (double)sa / (double)(sa - sb);
+        int x = qRound(a.x + t * (b.x - a.x));
+        int y = qRound(a.y + t * (b.y - a.y));
+
+        if ((x == a.x && y == a.y) || (x == b.x && y == b.y))
+        {
+            // split point rounds onto an endpoint. put the seg where most of it is.
+            if (qAbs(sa) > qAbs(sb)) (sa > 0 ? front : back).append(seg);
+            else (sb > 0 ? front : back).append(seg);
+            continue;
+        }
+
+        int mid = addVertex(x, y);
+
+        Seg s1 = seg;
+        s1.v2 = mid;
+        Seg s2 = seg;
+        s2.v1 = mid;
+        s2.offset = seg.offset + qRound(sqrt((double)(x - a.x) * (x - a.x) + (double)(y - a.y) * (y - a.y)));
+
+        (sa > 0 ? front : back).append(s1);
+        (sb > 0 ? front : back).append(s2);
+    }
+}
+
+int NodeBuilder::makeSubsector(QVector<Seg>& segs)
+{
+    DoomMapSubsector ss;
+    ss.firstseg = this->segs.size();
+    ss.numsegs = segs.size();
+    ss.sector = -1;
+    this->segs += segs;
+    out->subsectors.append(ss);
+    return ~(out->subsectors.size()-1);
+}
+
+int NodeBuilder::buildSubtree(QVector<Seg>& segs, float* bbox)
+{
+    getBoundingBox(segs, bbox);
+
+    int partition = pickPartition(segs, true);
+    if (partition < 0 && segs.size() > NodeBuilder_MaxCandidates)
+        partition = pickPartition(segs, false); // sampling might have missed the only usable lines
+    if (partition < 0)
+        return makeSubsector(segs); // convex
+
+    Seg pseg = segs[partition];
+    QVector<Seg> front;
+    QVector<Seg> back;
+    splitSegs(segs, pseg, front, back);
+    segs.clear();
+
+    if (!front.size() || !back.size())
+    {
+        // can happen if all splits rounded onto endpoints. give up on this set.
+        front += back;
+        return makeSubsector(front);
+    }
+
+    DoomMapNode node;
+    node.x = vertices[pseg.v1].x;
+    node.y = vertices[pseg.v1].y;
+    node.dx = vertices[pseg.v2].x - vertices[pseg.v1].x;
+    node.dy = vertices[pseg.v2].y - vertices[pseg.v1].y;
+    node.children[0] = buildSubtree(front, node.bbox[0]);
+    node.children[1] = buildSubtree(back, node.bbox[1]);
+    for (int i = 0; i < 2; i++)
+        node.zmin[i] = node.zmax[i] = 0;
+
+    out->nodes.append(node);
+    return out->nodes.size()-1;
+}
@@ -0,0 +1,53 @@
+#ifndef NODEBUILDER_H
+#define NODEBUILDER_H
+
+#include <QVector>
+#include "doommapnodes.h"
+
+class DoomMap;
+
+// builds classic (vanilla) nodes for the map.
+// partition candidates are evaluated in parallel; output only depends on the map, not on thread count.
+class NodeBuilder
+{
+public:
+    NodeBuilder(DoomMap* map);
+
+    // builds the nodes into out. returns false if there's nothing to build from (no linedefs).
+    bool build(DoomMapNodes& out);
+
+    // internal seg representation. vertices are integer, as that's what classic nodes can store anyway.
+    struct Seg
+    {
+        int v1;
+        int v2;
+        int linedef;
+        int side;
+        int offset;
+        int angle;
+    };
+
+    struct Vertex
+    {
+        int x;
+        int y;
+    };
+
+private:
+    DoomMap* map;
+
+    QVector<Vertex> vertices;
+    QVector<Seg> segs; // output segs, in subsector order
+
+    DoomMapNodes* out;
+
+    int addVertex(int x, int y);
+    void createSegs(QVector<Seg>& initial);
+    int buildSubtree(QVector<Seg>& segs, float* bbox);
+    int pickPartition(const QVector<Seg>& segs, bool sampled);
+    void splitSegs(const QVector<Seg>& segs, const Seg& partition, QVector<Seg>& front, QVector<Seg>& back);
+    int makeSubsector(QVector<Seg>& segs);
+    void getBoundingBox(const QVector<Seg>& segs, float* bbox);
+};
+
+#endif // NODEBUILDER_H
@@ -0,0 +1,657 @@
+#include "triangulator.h"
+#include "geometry.h"
+#include <algorithm>
+
+// this follows the earcut algorithm (https://github.com/mapbox/earcut), with fixed point coordinates and index-linked nodes.
+
+Triangulator::Triangulator()
+{
+    numNodes = 0;
+    failed = false;
+    hashed = false;
+    minX = minY = hashSize = 0;
+}
+
+int Triangulator::newNode(int i, qint64 x, qint64 y)
+{
+    // nodes are never freed during one triangulation, the buffer is only reused by the next one.
+    if (numNodes == nodes.size())
+        nodes.resize(qMax(64, nodes.size()*2));
+
+    Node& n = nodes[numNodes];
+    n.x = x;
+    n.y = y;
+    n.i = i;
+    n.prev = n.next = numNodes;
+    n.z = 0;
+    n.prevZ = n.nextZ = -1;
+    return numNodes++;
+}
+
+int Triangulator::insertNode(int i, const QPointF& p, int last)
+{
+    FixedPoint fp = Geometry::toFixed(p);
+    int n = newNode(i, fp.x, fp.y);
+    if (last >= 0)
+    {
+        nodes[n].next = nodes[last].next;
+        nodes[n].prev = last;
+        nodes[nodes[last].next].prev = n;
+        nodes[last].next = n;
+    }
+
+    return n;
+}
+
+void Triangulator::removeNode(int p)
+{
+    nodes[nodes[p].next].prev = nodes[p].prev;
+    nodes[nodes[p].prev].next = nodes[p].next;
+
+    if (nodes[p].prevZ >= 0) nodes[nodes[p].prevZ].nextZ = nodes[p].nextZ;
+    if (nodes[p].nextZ >= 0) nodes[nodes[p].nextZ].prevZ = nodes[p].prevZ;
+}
+
+void Triangulator::addTriangle(int a, int b, int c)
+{
+    indexList.append(nodes[a].i);
+    indexList.append(nodes[b].i);
+    indexList.append(nodes[c].i);
+}
+
+bool Triangulator::triangulate(const QPolygonF& outer, const QList<QPolygonF>& holes)
+{
+    // resize(0) keeps the allocated memory
+    pointList.resize(0);
+    indexList.resize(0);
+    numNodes = 0;
+    failed = false;
+    hashed = false;
+
+    pointList += outer;
+    QVector<int> holeStarts;
+    for (int i = 0; i < holes.size(); i++)
+    {
+        holeStarts.append(pointList.size());
+        pointList += holes[i];
+    }
+
+    int outerNode = linkedList(0, outer.size(), true);
+    if (outerNode < 0 || nodes[outerNode].next == nodes[outerNode].prev)
+        return false;
+
+    if (holeStarts.size())
+        outerNode = eliminateHoles(holeStarts, outerNode);
+
+    if (pointList.size() > HashThreshold)
+    {
+        FixedPoint p = Geometry::toFixed(pointList[0]);
+        qint64 maxX = minX = p.x;
+        qint64 maxY = minY = p.y;
+        for (int i = 1; i < pointList.size(); i++)
+        {
+            p = Geometry::toFixed(pointList[i]);
+            minX = qMin(minX, p.x);
+            minY = qMin(minY, p.y);
+            maxX = qMax(maxX, p.x);
+            maxY = qMax(maxY, p.y);
+        }
+
+        hashSize = qMax(maxX - minX, maxY - minY);
+        hashed = hashSize > 0;
+    }
+
+    earcutLinked(outerNode, 0);
+    return !failed;
+}
+
+// makes a circular list from points [start, end). outer boundary goes counterclockwise, holes clockwise.
+int Triangulator::linkedList(int start, int end, bool outer)
+{
+    if (end - start < 1)
+        return -1;
+
+    qint64 sum = 0;
+    for (int i = start, j = end-1; i < end; j = i++)
+    {
+        FixedPoint pi = Geometry::toFixed(pointList[i]);
+        FixedPoint pj = Geometry::toFixed(pointList[j]);
+        sum += (pj.x - pi.x) * (pi.y + pj.y);
+    }
+
+    int last = -1;
+    if (outer == (sum > 0))
+    {
+        for (int i = start; i < end; i++)
+            last = insertNode(i, pointList[i], last);
+    }
+    else
+    {
+        for (int i = end-1; i >= start; i--)
+            last = insertNode(i, pointList[i], last);
+    }
+
+    if (last >= 0 && equals(last, nodes[last].next))
+    {
+        int next = nodes[last].next;
+        removeNode(last);
+        last = next;
+    }
+
+    return last;
+}
+
+// removes duplicate and collinear points
+int Triangulator::filterPoints(int start, int end)
+{
+    if (start < 0)
+        return start;
+    if (end < 0)
+        end = start;
+
+    int p = start;
+    bool again;
+    do
+    {
+        again = false;
+        if (equals(p, nodes[p].next) || area(nodes[p].prev, p, nodes[p].next) == 0)
+        {
+            removeNode(p);
+            p = end = nodes[p].prev;
+            if (p == nodes[p].next)
+                break;
+            again = true;
+        }
+        else p = nodes[p].next;
+    }
+    while (again || p != end);
+
+    return end;
+}
+
+void Triangulator::earcutLinked(int ear, int pass)
+{
+    if (ear < 0)
+        return;
+
+    if (pass == 0 && hashed)
+        indexCurve(ear);
+
+    int stop = ear;
+    while (nodes[ear].prev != nodes[ear].next)
+    {
+        int prev = nodes[ear].prev;
+        int next = nodes[ear].next;
+
+        if (hashed ? isEarHashed(ear) : isEar(ear))
+        {
+            addTriangle(prev, ear, next);
+            removeNode(ear);
+            ear = nodes[next].next;
+            stop = nodes[next].next;
+            continue;
+        }
+
+        ear = next;
+
+        // went around without finding an ear
+        if (ear == stop)
+        {
+            if (pass == 0)
+            {
+                earcutLinked(filterPoints(ear), 1);
+            }
+            else if (pass == 1)
+            {
+                ear = cureLocalIntersections(filterPoints(ear));
+                earcutLinked(ear, 2);
+            }
+            else
+            {
+                splitEarcut(ear);
+            }
+
+            break;
+        }
+    }
+}
+
+bool Triangulator::isEar(int ear)
+{
+    int a = nodes[ear].prev;
+    int b = ear;
+    int c = nodes[ear].next;
+    if (area(a, b, c) >= 0)
+        return false; // reflex
+
+    qint64 ax = nodes[a].x, bx = nodes[b].x, cx = nodes[c].x;
+    qint64 ay = nodes[a].y, by = nodes[b].y, cy = nodes[c].y;
+    qint64 x0 = qMin(ax, qMin(bx, cx));
+    qint64 y0 = qMin(ay, qMin(by, cy));
+    qint64 x1 = qMax(ax, qMax(bx, cx));
+    qint64 y1 = qMax(ay, qMax(by, cy));
+
+    // no other point may be inside. points at the same place as the first corner belong to the same vertex and don't count.
+    int p = nodes[c].next;
+    while (p != a)
+    {
+        const Node& n = nodes[p];
+        if (n.x >= x0 && n.x <= x1 && n.y >= y0 && n.y <= y1 &&
+                !(n.x == ax && n.y == ay) &&
+                pointInTriangle(ax, ay, bx, by, cx, cy, n.x, n.y) &&
+                area(n.prev, p, n.next) >= 0)
+            return false;
+        p = n.next;
+    }
+
+    return true;
+}
+
+// same as isEar, but only checks points whose z-order is between the corners of the triangle's bounding box.
+// points are checked going both ways from the ear along the curve, so the ones close to it are found first.
+bool Triangulator::isEarHashed(int ear)
+{
+    int a = nodes[ear].prev;
+    int b = ear;
+    int c = nodes[ear].next;
+    if (area(a, b, c) >= 0)
+        return false;
+
+    qint64 ax = nodes[a].x, bx = nodes[b].x, cx = nodes[c].x;
+    qint64 ay = nodes[a].y, by = nodes[b].y, cy = nodes[c].y;
+    qint64 x0 = qMin(ax, qMin(bx, cx));
+    qint64 y0 = qMin(ay, qMin(by, cy));
+    qint64 x1 = qMax(ax, qMax(bx, cx));
+    qint64 y1 = qMax(ay, qMax(by, cy));
+
+    qint64 minZ = zOrder(x0, y0);
+    qint64 maxZ = zOrder(x1, y1);
+
+    for (int dir = 0; dir < 2; dir++)
+    {
+        int p = dir ? nodes[ear].nextZ : nodes[ear].prevZ;
+        while (p >= 0 && (dir ? nodes[p].z <= maxZ : nodes[p].z >= minZ))
+        {
+            const Node& n = nodes[p];
+            if (p != a && p != c &&
+                    n.x >= x0 && n.x <= x1 && n.y >= y0 && n.y <= y1 &&
+                    !(n.x == ax && n.y == ay) &&
+                    pointInTriangle(ax, ay, bx, by, cx, cy, n.x, n.y) &&
+                    area(n.prev, p, n.next) >= 0)
+                return false;
+            p = dir ? n.nextZ : n.prevZ;
+        }
+    }
+
+    return true;
+}
+
+// position on the z-order curve: 15 bits per axis inside the bounding box of the polygon, interleaved
+qint64 Triangulator::zOrder(qint64 x, qint64 y) const
+{
+    qint64 zx = (x - minX) * 32767 / hashSize;
+    qint64 zy = (y - minY) * 32767 / hashSize;
+
+    zx = (zx | (zx << 8)) & 0x00FF00FF;
+    zx = (zx | (zx << 4)) & 0x0F0F0F0F;
+    zx = (zx | (zx << 2)) & 0x33333333;
+    zx = (zx | (zx << 1)) & 0x55555555;
+
+    zy = (zy | (zy << 8)) & 0x00FF00FF;
+    zy = (zy | (zy << 4)) & 0x0F0F0F0F;
+    zy = (zy | (zy << 2)) & 0x33333333;
+    zy = (zy | (zy << 1)) & 0x55555555;
+
+    return zx | (zy << 1);
+}
+
+struct Triangulator_ZLess
+{
+    const QVector<qint64>* z;
+
+    bool operator()(int a, int b) const
+    {
+        if ((*z)[a] != (*z)[b]) return (*z)[a] < (*z)[b];
+        return a < b;
+    }
+};
+
+// links the nodes of one ring in z-order. earcut does a merge sort on the list, here they're just collected and sorted.
+void Triangulator::indexCurve(int start)
+{
+    zSort.resize(0);
+    int p = start;
+    do
+    {
+        nodes[p].z = zOrder(nodes[p].x, nodes[p].y);
+        zSort.append(p);
+        p = nodes[p].next;
+    }
+    while (p != start);
+
+    QVector<qint64> z(numNodes);
+    for (int i = 0; i < zSort.size(); i++)
+        z[zSort[i]] = nodes[zSort[i]].z;
+
+    Triangulator_ZLess less;
+    less.z = &z;
+    std::sort(zSort.begin(), zSort.end(), less);
+
+    for (int i = 0; i < zSort.size(); i++)
+    {
+        nodes[zSort[i]].prevZ = i > 0 ? zSort[i-1] : -1;
+        nodes[zSort[i]].nextZ = i+1 < zSort.size() ? zSort[i+1] : -1;
+    }
+}
+
+// cuts off small self-intersections
+int Triangulator::cureLocalIntersections(int start)
+{
+    int p = start;
+    do
+    {
+        int a = nodes[p].prev;
+        int b = nodes[nodes[p].next].next;
+
+        if (!equals(a, b) && intersects(a, p, nodes[p].next, b) && locallyInside(a, b) && locallyInside(b, a))
+        {
+            addTriangle(a, p, b);
+            removeNode(p);
+            removeNode(nodes[p].next);
+            p = start = b;
+        }
+
+        p = nodes[p].next;
+    }
+    while (p != start);
+
+    return filterPoints(p);
+}
+
+// last resort: split the polygon in two along a valid diagonal and do both halves separately
+void Triangulator::splitEarcut(int start)
+{
+    int a = start;
+    do
+    {
+        int b = nodes[nodes[a].next].next;
+        while (b != nodes[a].prev)
+        {
+            if (nodes[a].i != nodes[b].i && isValidDiagonal(a, b))
+            {
+                int c = splitPolygon(a, b);
+                a = filterPoints(a, nodes[a].next);
+                c = filterPoints(c, nodes[c].next);
+                earcutLinked(a, 0);
+                earcutLinked(c, 0);
+                return;
+            }
+
+            b = nodes[b].next;
+        }
+
+        a = nodes[a].next;
+    }
+    while (a != start);
+
+    failed = true;
+}
+
+struct Triangulator_HoleLess
+{
+    const QVector<qint64>* x;
+    const QVector<qint64>* y;
+
+    bool operator()(int a, int b) const
+    {
+        if ((*x)[a] != (*x)[b]) return (*x)[a] < (*x)[b];
+        if ((*y)[a] != (*y)[b]) return (*y)[a] < (*y)[b];
+        return a < b;
+    }
+};
+
+int Triangulator::eliminateHoles(const QVector<int>& starts, int outer)
+{
+    QVector<int> queue;
+    for (int i = 0; i < starts.size(); i++)
+    {
+        int end = (i+1 < starts.size()) ? starts[i+1] : pointList.size();
+        int list = linkedList(starts[i], end, false);
+        if (list < 0 || list == nodes[list].next)
+            continue;
+        queue.append(getLeftmost(list));
+    }
+
+    // holes are joined from left to right
+    QVector<qint64> x(numNodes);
+    QVector<qint64> y(numNodes);
+    for (int i = 0; i < queue.size(); i++)
+    {
+        x[queue[i]] = nodes[queue[i]].x;
+        y[queue[i]] = nodes[queue[i]].y;
+    }
+
+    Triangulator_HoleLess less;
+    less.x = &x;
+    less.y = &y;
+    std::sort(queue.begin(), queue.end(), less);
+
+    for (int i = 0; i < queue.size(); i++)
+        outer = eliminateHole(queue[i], outer);
+
+    return outer;
+}
+
+int Triangulator::eliminateHole(int hole, int outer)
+{
+    int bridge = findHoleBridge(hole, outer);
+    if (bridge < 0)
+    {
+        failed = true;
+        return outer;
+    }
+
+    int bridgeReverse = splitPolygon(bridge, hole);
+    filterPoints(bridgeReverse, nodes[bridgeReverse].next);
+    return filterPoints(bridge, nodes[bridge].next);
+}
+
+// intersection point from findHoleBridge isn't integer, so this one is in doubles
+static inline bool Triangulator_PointInTriangle(double ax, double ay, double bx, double by, double cx, double cy, double px, double py)
+{
+    return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+           (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+           (bx - px) * (cy - py) >= (cx - px) * (by - py);
+}
+
+// David Eberly's algorithm for finding a bridge between the hole and the outer polygon
+int Triangulator::findHoleBridge(int hole, int outer)
+{
+    int p = outer;
+    qint64 hx = nodes[hole].x;
+    qint64 hy = nodes[hole].y;
+    double qx = -1e300;
+    int m = -1;
+
+    // find a segment intersected by a ray from the leftmost hole point to the left
+    do
+    {
+        const Node& n = nodes[p];
+        const Node& nn = nodes[n.next];
+        if (hy <= n.y && hy >= nn.y && nn.y != n.y)
+        {
+            double x = n.x + (double)(hy - n.y) * (nn.x - n.x) / (nn.y - n.y);
+            if (x <= hx && x > qx)
+            {
+                qx = x;
+                m = (n.x < nn.x) ? p : n.next;
+                if (x == hx)
+                    return m; // hole touches outer segment, pick leftmost endpoint
+            }
+        }
+
+        p = n.next;
+    }
+    while (p != outer);
+
+    if (m < 0)
+        return -1;
+
+    // look for points inside the triangle of hole point, segment intersection and endpoint.
+    // if there are none, m is the bridge. otherwise take the point with the smallest angle to the ray.
+    int stop = m;
+    qint64 mx = nodes[m].x;
+    qint64 my = nodes[m].y;
+    double tanMin = 1e300;
+
+    p = m;
+    do
+    {
+        const Node& n = nodes[p];
+        if (hx >= n.x && n.x >= mx && hx != n.x &&
+                Triangulator_PointInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, n.x, n.y))
+        {
+            double tan = (double)qAbs(hy - n.y) / (hx - n.x);
+            if (locallyInside(p, hole) &&
+                    (tan < tanMin || (tan == tanMin && (n.x > nodes[m].x || (n.x == nodes[m].x && sectorContainsSector(m, p))))))
+            {
+                m = p;
+                tanMin = tan;
+            }
+        }
+
+        p = n.next;
+    }
+    while (p != stop);
+
+    return m;
+}
+
+int Triangulator::getLeftmost(int start)
+{
+    int p = start;
+    int leftmost = start;
+    do
+    {
+        if (nodes[p].x < nodes[leftmost].x || (nodes[p].x == nodes[leftmost].x && nodes[p].y < nodes[leftmost].y))
+            leftmost = p;
+        p = nodes[p].next;
+    }
+    while (p != start);
+
+    return leftmost;
+}
+
+// links a and b with a bridge. if they are in one polygon, splits it in two; if a is in the outer and b in a hole, merges them.
+int Triangulator::splitPolygon(int a, int b)
+{
+    int a2 = newNode(nodes[a].i, nodes[a].x, nodes[a].y);
+    int b2 = newNode(nodes[b].i, nodes[b].x, nodes[b].y);
+    int an = nodes[a].next;
+    int bp = nodes[b].prev;
+
+    nodes[a].next = b;
+    nodes[b].prev = a;
+
+    nodes[a2].next = an;
+    nodes[an].prev = a2;
+
+    nodes[b2].next = a2;
+    nodes[a2].prev = b2;
+
+    nodes[bp].next = b2;
+    nodes[b2].prev = bp;
+
+    return b2;
+}
+
+bool Triangulator::pointInTriangle(qint64 ax, qint64 ay, qint64 bx, qint64 by, qint64 cx, qint64 cy, qint64 px, qint64 py)
+{
+    return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+           (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+           (bx - px) * (cy - py) >= (cx - px) * (by - py);
+}
+
+bool Triangulator::intersects(int p1, int q1, int p2, int q2) const
+{
+    return Geometry::segmentsIntersect(FixedPoint(nodes[p1].x, nodes[p1].y), FixedPoint(nodes[q1].x, nodes[q1].y),
+                                       FixedPoint(nodes[p2].x, nodes[p2].y), FixedPoint(nodes[q2].x, nodes[q2].y));
+}
+
+bool Triangulator::intersectsPolygon(int a, int b) const
+{
+    int p = a;
+    do
+    {
+        int pn = nodes[p].next;
+        if (nodes[p].i != nodes[a].i && nodes[pn].i != nodes[a].i && nodes[p].i != nodes[b].i && nodes[pn].i != nodes[b].i &&
+                intersects(p, pn, a, b))
+            return true;
+        p = pn;
+    }
+    while (p != a);
+
+    return false;
+}
+
+bool Triangulator::locallyInside(int a, int b) const
+{
+    int prev = nodes[a].prev;
+    int next = nodes[a].next;
+    if (area(prev, a, next) < 0)
+        return area(a, b, next) >= 0 && area(a, prev, b) >= 0;
+    return area(a, b, prev) < 0 || area(a, next, b) < 0;
+}
+
+bool Triangulator::middleInside(int a, int b) const
+{
+    int p = a;
+    bool inside = false;
+    // doubled coordinates, so the middle point stays integer
+    qint64 px = nodes[a].x + nodes[b].x;
+    qint64 py = nodes[a].y + nodes[b].y;
+    do
+    {
+        const Node& n = nodes[p];
+        const Node& nn = nodes[n.next];
+        qint64 y1 = n.y * 2;
+        qint64 y2 = nn.y * 2;
+        if ((y1 > py) != (y2 > py) && y2 != y1)
+        {
+            // px < x1 + (x2 - x1) * (py - y1) / (y2 - y1), without the division
+            qint64 lhs = (px - n.x * 2) * (y2 - y1);
+            qint64 rhs = (nn.x - n.x) * 2 * (py - y1);
+            if ((y2 > y1) ? (lhs < rhs) : (lhs > rhs))
+                inside = !inside;
+        }
+
+        p = n.next;
+    }
+    while (p != a);
+
+    return inside;
+}
+
+bool Triangulator::sectorContainsSector(int m, int p) const
+{
+    return area(nodes[m].prev, m, nodes[p].prev) < 0 && area(nodes[p].next, m, nodes[m].next) < 0;
+}
+
+bool Triangulator::isValidDiagonal(int a, int b) const
+{
+    int ap = nodes[a].prev;
+    int an = nodes[a].next;
+    int bp = nodes[b].prev;
+    int bn = nodes[b].next;
+
+    if (nodes[an].i == nodes[b].i || nodes[ap].i == nodes[b].i || intersectsPolygon(a, b))
+        return false;
+
+    // locally visible, and no zero-length cases
+    if (locallyInside(a, b) && locallyInside(b, a) && middleInside(a, b) &&
+            (area(ap, a, bp) != 0 || area(a, bp, b) != 0))
+        return true;
+
+    // special zero-length case
+    return equals(a, b) && area(ap, a, an) > 0 && area(bp, b, bn) > 0;
+}
@@ -0,0 +1,91 @@
+#ifndef TRIANGULATOR_H
+#define TRIANGULATOR_H
+
+#include <QVector>
+#include <QList>
+#include <QPolygonF>
+
+// ear clipping triangulator for polygons with holes.
+// holes are joined to the outer boundary with bridge edges first, then ears are cut from the resulting single loop.
+// large polygons keep their points on a z-order curve too, so the ear test only looks at points near the ear instead of all of them.
+// all predicates are exact (coordinates are converted to fixed point from geometry.h and compared in 64-bit integers),
+// so vertices touching each other or lying on other edges are handled without nudging anything.
+// one object can be reused for many polygons; its buffers are kept between calls.
+class Triangulator
+{
+public:
+    Triangulator();
+
+    // orientation of outer and holes doesn't matter. holes must be inside outer.
+    // returns false if some part couldn't be triangulated; triangles that were made are still there.
+    bool triangulate(const QPolygonF& outer, const QList<QPolygonF>& holes);
+
+    // input points, outer first, then holes in order
+    const QVector<QPointF>& points() const { return pointList; }
+    // 3 indices into points() per triangle. triangles are counterclockwise (with y going up).
+    const QVector<int>& indices() const { return indexList; }
+
+private:
+    struct Node
+    {
+        qint64 x;
+        qint64 y;
+        int i; // index in pointList
+        int prev;
+        int next;
+        // nodes of the ring sorted along a z-order curve, only used for large polygons
+        qint64 z;
+        int prevZ;
+        int nextZ;
+    };
+
+    QVector<QPointF> pointList;
+    QVector<int> indexList;
+    QVector<Node> nodes;
+    int numNodes;
+    bool failed;
+    // polygons with more points than this use the z-order hash in isEar. below that, going around the ring is faster.
+    static const int HashThreshold = 80;
+    bool hashed;
+    qint64 minX, minY, hashSize;
+    QVector<int> zSort;
+
+    int newNode(int i, qint64 x, qint64 y);
+    int insertNode(int i, const QPointF& p, int last);
+    void removeNode(int p);
+    int linkedList(int start, int end, bool outer);
+    int filterPoints(int start, int end = -1);
+    void earcutLinked(int ear, int pass);
+    bool isEar(int ear);
+    bool isEarHashed(int ear);
+    qint64 zOrder(qint64 x, qint64 y) const;
+    void indexCurve(int start);
+    int cureLocalIntersections(int start);
+    void splitEarcut(int start);
+    int eliminateHoles(const QVector<int>& starts, int outer);
+    int eliminateHole(int hole, int outer);
+    int findHoleBridge(int hole, int outer);
+    int getLeftmost(int start);
+    int splitPolygon(int a, int b);
+    void addTriangle(int a, int b, int c);
+
+    bool equals(int a, int b) const { return nodes[a].x == nodes[b].x && nodes[a].y == nodes[b].y; }
+    // < 0 if p, q, r turn counterclockwise
+    qint64 area(int p, int q, int r) const
+    {
+        const Node& np = nodes[p];
+        const Node& nq = nodes[q];
+        const Node& nr = nodes[r];
+        return (nq.y - np.y) * (nr.x - nq.x) - (nq.x - np.x) * (nr.y - nq.y);
+    }
+
+    bool intersects(int p1, int q1, int p2, int q2) const;
+    bool intersectsPolygon(int a, int b) const;
+    bool locallyInside(int a, int b) const;
+    bool middleInside(int a, int b) const;
+    bool sectorContainsSector(int m, int p) const;
+    bool isValidDiagonal(int a, int b) const;
+    static bool pointInTriangle(qint64 ax, qint64 ay, qint64 bx, qint64 by, qint64 cx, qint64 cy, qint64 px, qint64 py);
+};
+
+#endif // TRIANGULATOR_H
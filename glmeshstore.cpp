@@ -0,0 +1,79 @@
+#include "glmeshstore.h"
+
+GLMeshStore::GLMeshStore(int parts)
+{
+    this->parts = parts;
+    frame = 0;
+    meshCount = 0;
+}
+
+GLMeshStore::~GLMeshStore()
+{
+    clear();
+}
+
+GLArray* GLMeshStore::find(int id, int part) const
+{
+    int index = id*parts+part;
+    if (id < 0 || index >= meshes.size())
+        return 0;
+    return meshes[index];
+}
+
+GLArray* GLMeshStore::get(int id, int part)
+{
+    if (id < 0)
+        return 0;
+
+    int index = id*parts+part;
+    if (index >= meshes.size())
+    {
+        meshes.resize((id+1)*parts);
+        lastUsed.resize(id+1);
+    }
+
+    lastUsed[id] = frame;
+    if (!meshes[index])
+    {
+        meshes[index] = new GLArray();
+        meshCount++;
+    }
+
+    return meshes[index];
+}
+
+void GLMeshStore::beginFrame(int maxAge)
+{
+    frame++;
+    // ages only need to be checked once in a while
+    if ((frame & 63) == 0)
+        collect(maxAge);
+}
+
+void GLMeshStore::collect(int maxAge)
+{
+    for (int id = 0; id < lastUsed.size(); id++)
+    {
+        if (frame - lastUsed[id] <= maxAge)
+            continue;
+
+        for (int part = 0; part < parts; part++)
+        {
+            GLArray*& mesh = meshes[id*parts+part];
+            if (!mesh)
+                continue;
+            delete mesh;
+            mesh = 0;
+            meshCount--;
+        }
+    }
+}
+
+void GLMeshStore::clear()
+{
+    for (int i = 0; i < meshes.size(); i++)
+        delete meshes[i];
+    meshes.clear();
+    lastUsed.clear();
+    meshCount = 0;
+}
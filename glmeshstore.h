@@ -0,0 +1,37 @@
+#ifndef GLMESHSTORE_H
+#define GLMESHSTORE_H
+
+#include <QVector>
+#include "glarray.h"
+
+// gl geometry of map components. this is owned by a view, so the map itself has no gl data and stays cheap to copy.
+// meshes are indexed by component id and part (e.g. top, bottom and middle of a sidedef).
+// they are only created for components that get drawn, and dropped again when they weren't drawn for a while.
+class GLMeshStore
+{
+public:
+    GLMeshStore(int parts = 1);
+    ~GLMeshStore();
+
+    // returns 0 if the mesh wasn't built yet or was dropped
+    GLArray* find(int id, int part = 0) const;
+    // same, but creates an empty mesh if needed. this marks the component as used in the current frame.
+    GLArray* get(int id, int part = 0);
+
+    // starts next frame. every so often this also drops meshes that weren't used for maxAge frames.
+    void beginFrame(int maxAge);
+    void clear();
+
+    int getMeshCount() const { return meshCount; }
+
+private:
+    int parts;
+    int frame;
+    int meshCount;
+    QVector<GLArray*> meshes; // id*parts+part
+    QVector<int> lastUsed; // frame, by id
+
+    void collect(int maxAge);
+};
+
+#endif // GLMESHSTORE_H
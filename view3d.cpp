@@ -1,961 +1,1291 @@
-#include "view3d.h"
-#include <QDebug>
-#include "mainwindow.h"
-#include "glarray.h"
-#include <cmath> // M_PI, tan()
-#include <QApplication>
-#include "data/texman.h"
-#include <QTime>
-
-static const QGLFormat& GetView3DFormat()
-{
-    static QGLFormat fmt;
-    fmt = QGLFormat();
-    fmt.setVersion(2, 0);
-    fmt.setProfile(QGLFormat::CompatibilityProfile);
-    //fmt.setSampleBuffers(true);
-    return fmt;
-}
-
-View3D::View3D(QWidget* parent) : QGLWidget(GetView3DFormat(), parent, MainWindow::get()->getSharedGLWidget()),
-                                  highlightShader(context(), this)
-{
-    setMouseTracking(true);
-    setFocusPolicy(Qt::StrongFocus);
-
-    repaintTimer = new QTimer(this);
-    connect(repaintTimer, SIGNAL(timeout()), this, SLOT(repaintTimerHandler()));
-    repaintTimer->setInterval(2); // ~30fps
-    repaintTimer->start();
-
-    wasVisible = false;
-    mouseXLast = mouseYLast = -1;
-
-    running = false;
-
-    hoverFBO = 0;
-
-    rdist = 1024;
-}
-
-void View3D::initShader(QString name, QGLShaderProgram& out, QString filenamevx, QString filenamefr)
-{
-    if (!out.addShaderFromSourceFile(QGLShader::Vertex, filenamevx))
-    {
-        qDebug("View3D: failed to compile %s shader/vertex: %s", name.toUtf8().data(), highlightShader.log().toUtf8().data());
-        return;
-    }
-
-    if (!out.addShaderFromSourceFile(QGLShader::Fragment, filenamefr))
-    {
-        qDebug("View3D: failed to compile %s shader/fragment: %s", name.toUtf8().data(), highlightShader.log().toUtf8().data());
-        return;
-    }
-
-    if (!out.link())
-    {
-        qDebug("View3D: failed to link %s shader: %s", name.toUtf8().data(), highlightShader.log().toUtf8().data());
-        return;
-    }
-}
-
-void View3D::initializeGL()
-{
-    qDebug("initializing GL...");
-
-    // init entity highlight shader (basically mixes some highlight color with the texture)
-    initShader("highlight", highlightShader, ":/resources/highlightShader.vx", ":/resources/highlightShader.fr");
-
-    // init midtex select shader (stencil-like rendering only with alpha >0.5 of the actual midtex texture, used in offscreen rendering of masks)
-    initShader("midtex select", midtexSelectShader, ":/resources/midtexSelectShader.vx", ":/resources/midtexSelectShader.fr");
-
-    highlightShader.setUniformValue("uHighlightColor", QVector4D(0, 0, 0, 0));
-}
-
-void View3D::paintGL()
-{
-    setPerspective(140);
-
-    if (!hoverFBO || hoverFBO->width() != width() || hoverFBO->height() != height())
-    {
-        if (hoverFBO) delete hoverFBO;
-        hoverFBO = new QGLFramebufferObject(width(), height(), QGLFramebufferObject::Depth, GL_TEXTURE_2D);
-    }
-
-    hoverFBO->bind();
-    render(0);
-    hoverFBO->release();
-    // slow operation. maybe do something about it later?
-    QImage fboImage(hoverFBO->toImage());
-    QImage image(fboImage.constBits(), fboImage.width(), fboImage.height(), QImage::Format_ARGB32);
-    QRgb colorCenter = image.pixel(image.width()/2, image.height()/2);
-    // unpack hovered surface.
-    hoverType = (HoverType)((colorCenter & 0x00FF0000) >> 16);
-    hoverId = ((colorCenter & 0xFFFF) << 8) | ((colorCenter & 0xFF000000) >> 24);
-    //qDebug("hoverType = %d; hoverId = %d", hoverType, hoverId);
-
-    render(1);
-}
-
-
-void View3D::resizeGL(int width, int height)
-{
-    //setClipRect(0, 0, width, height);
-    // this is done each frame anyway
-    update();
-}
-
-#include <QElapsedTimer>
-static QElapsedTimer qetfps;
-static int intfps = 0;
-void View3D::repaintTimerHandler()
-{
-    if (!qetfps.isValid())
-        qetfps.start();
-
-    intfps++;
-    if (qetfps.elapsed() > 1000)
-    {
-        qDebug("FPS: %d", intfps);
-        intfps = 0;
-        qetfps.restart();
-    }
-
-    // do something else? otherwise just remove this and connect to repaint()
-    //update();
-
-    if (isVisible() && !wasVisible)
-    {
-        //grabMouse();
-        //grabKeyboard();
-        becameVisible();
-        wasVisible = true;
-    }
-    else if (!isVisible() && wasVisible)
-    {
-        //releaseMouse();
-        //releaseKeyboard();
-        wasVisible = false;
-    }
-
-    if (!isVisible())
-        return;
-
-    updateMouseAngle();
-
-    // move the player
-    float dx = 0;
-    float dy = 0;
-    if (moveForward) dy += 1;
-    if (moveBackward) dy -= 1;
-    if (moveLeft) dx -= 1;
-    if (moveRight) dx += 1;
-
-    float movemul = 8;
-    if (running)
-        movemul *= 3;
-
-    QLineF vertvec(0, 0, 1, 0);
-    vertvec.setAngle(angX);
-    posZ -= dy*vertvec.dy()*movemul;
-    QLineF movevec(0, 0, dx, dy*vertvec.dx());
-    movevec.setAngle(movevec.angle()-angZ);
-    posX += movevec.dx()*movemul;
-    posY -= movevec.dy()*movemul;
-
-    //
-    repaint();
-}
-
-void View3D::initMap()
-{
-    DoomMap* cmap = MainWindow::get()->getMap();
-
-    //
-    posX = posY = posZ = 0;
-    posZ = 48;
-    angX = angY = angZ = 0;
-
-    mouseXLast = mouseYLast = -1;
-
-    moveForward = moveBackward = moveLeft = moveRight = 0;
-}
-
-void View3D::updateMouseAngle()
-{
-    QPoint oldcpos = mapFromGlobal(QCursor::pos());
-
-    int deltaX = 0, deltaY = 0;
-
-    // check if center. ignore events that point to widget's center, as these are our own events.
-    QPoint center(width()/2, height()/2);
-
-    if (mouseXLast >= 0 && mouseYLast >= 0)
-    {
-        deltaX = center.x()-oldcpos.x();
-        deltaY = center.y()-oldcpos.y();
-
-        //if (deltaX) deltaX = (deltaX < 0) ? -1 : 1;
-        //if (deltaY) deltaY = (deltaY < 0) ? -1 : 1;
-
-        float mper1 = 0.25;
-        angX += (float)deltaY * mper1;
-        if (angX < -90) angX = -90;
-        else if (angX > 90) angX = 90;
-
-        angZ += (float)deltaX * mper1;
-        while (angZ < 0)
-            angZ += 360;
-        while (angZ > 360)
-            angZ -= 360;
-    }
-
-    mouseXLast = oldcpos.x();
-    mouseYLast = oldcpos.y();
-
-    QCursor c = cursor();
-    c.setPos(mapToGlobal(center));
-    c.setShape(Qt::BlankCursor);
-    setCursor(c);
-}
-
-void View3D::mousePressEvent(QMouseEvent* e)
-{
-
-}
-
-void View3D::mouseReleaseEvent(QMouseEvent* e)
-{
-
-}
-
-void View3D::wheelEvent(QWheelEvent* e)
-{
-
-}
-
-void View3D::keyPressEvent(QKeyEvent *e)
-{
-    if (e->isAutoRepeat())
-        return;
-
-    if (e->key() == Qt::Key_Return ||
-        e->key() == Qt::Key_Enter)
-    {
-        MainWindow::get()->set3DMode(false);
-    }
-    else if (e->key() == Qt::Key_W)
-    {
-        moveForward = true;
-    }
-    else if (e->key() == Qt::Key_A)
-    {
-        moveLeft = true;
-    }
-    else if (e->key() == Qt::Key_S)
-    {
-        moveBackward = true;
-    }
-    else if (e->key() == Qt::Key_D)
-    {
-        moveRight = true;
-    }
-    else if (e->key() == Qt::Key_Shift)
-    {
-        running = true;
-        //qDebug("running on");
-    }
-}
-
-void View3D::keyReleaseEvent(QKeyEvent *e)
-{
-    if (e->isAutoRepeat())
-        return;
-
-    if (e->key() == Qt::Key_W)
-    {
-        moveForward = false;
-    }
-    else if (e->key() == Qt::Key_A)
-    {
-        moveLeft = false;
-    }
-    else if (e->key() == Qt::Key_S)
-    {
-        moveBackward = false;
-    }
-    else if (e->key() == Qt::Key_D)
-    {
-        moveRight = false;
-    }
-    else if ((e->key() == Qt::Key_Shift) || (e->modifiers() & Qt::ShiftModifier))
-    {
-        running = false;
-        //qDebug("running off");
-    }
-}
-
-void View3D::becameVisible()
-{
-    // todo reset mouse
-    mouseXLast = mouseYLast = -1;
-    running = false;
-
-    // set x/y position to 2d mode position, and z position to 0
-    posX = MainWindow::get()->getMouseX();
-    posY = -MainWindow::get()->getMouseY();
-    posZ = 0;
-    //qDebug("posX = %f, posY = %f; posZ = %f", posX, posY, posZ);
-}
-
-void View3D::setPerspective(float fov)
-{
-    glViewport(0, 0, width(), height());
-
-    float aspect = (float)width() / height();
-    float fovy = fov/aspect;
-    float zNear = 1;
-    float zFar = rdist;
-
-    GLdouble xmin, xmax, ymin, ymax;
-
-    ymax = zNear * tan(fovy * M_PI / 360.0);
-    ymin = -ymax;
-    xmin = ymin * aspect;
-    xmax = ymax * aspect;
-
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-
-    glFrustum(xmin, xmax, ymin, ymax, zNear, zFar);
-
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-
-    //
-    glRotatef(90-angX, 1, 0, 0);
-    glRotatef(angZ, 0, 0, 1);
-    glScalef(1, 1, -1);
-    glTranslatef(-posX, -posY, -posZ);
-}
-
-#define VIEW3D_HELPER_PACKHOVERID(a,b,c,d,hovertype,id) \
-    a = (int)(hovertype); \
-    b = ((id) & 0xFF0000) >> 16; \
-    c = ((id) & 0xFF00) >> 8; \
-    d = ((id) & 0xFF);
-
-// ewwwwwwwwwwwwwwwwwwwwwwwww this function is so ugly
-// it's used to compute similar, but different texture offsets for top/bottom/middle linedef parts.
-static void View3D_Helper_SetTextureOffsets(GLVertex& vv1, GLVertex& vv2, GLVertex& vv3, GLVertex& vv4, DoomMapSector* sector, DoomMapSector* other, DoomMapLinedef* linedef, DoomMapSidedef* sidedef, QLineF& line, TexTexture* tex, int part)
-{
-    bool top = (part == 0);
-    bool bottom = (part == 2);
-    bool middle = (part == 1);
-
-    float xbase = sidedef->offsetx;
-    float ybase = sidedef->offsety;
-    // lower unpegged means the texture should have origin at it's bottom, not top.
-    if (middle)
-    {
-        // if texture is lower unpegged, move it to bottom of own sidedef
-        if (linedef->dontpegbottom)
-        {
-            int ptd = (sector->heightceiling-sector->heightfloor) - tex->getHeight();
-            ybase -= ptd;
-        }
-    }
-    else if (linedef->dontpegbottom && !top)
-    {
-        int highestfloor = sector->heightfloor;
-        if (other) highestfloor = other->heightfloor;
-        int ptd = (sector->heightceiling-highestfloor) % tex->getHeight(); // 272 % 128
-        if (!other) ptd = -ptd;
-        ybase += ptd;
-    }
-    else if (!linedef->dontpegtop && top)
-    {
-        int ptd = tex->getHeight() - (sector->heightceiling - other->heightceiling);
-        ybase += ptd;
-    }
-    xbase /= tex->getWidth();
-    ybase /= tex->getHeight();
-    float xlen = line.length() / tex->getWidth();
-    float ylen1 = (vv1.z-vv4.z) / tex->getHeight();
-    float ylen2 = (vv2.z-vv3.z) / tex->getHeight();
-
-    vv1.u = xbase;
-    vv1.v = ybase;
-    vv2.u = xbase+xlen;
-    vv2.v = ybase;
-    vv3.u = xbase+xlen;
-    vv3.v = ybase+ylen2;
-    vv4.u = xbase;
-    vv4.v = ybase+ylen1;
-}
-
-struct ScheduledObject
-{
-    View3D* view3d;
-    QVector4D color_hl;
-    QVector4D color_sel;
-    float z;
-
-    virtual void render(int pass) = 0;
-    virtual QVector4D getHighlight(int pass) = 0;
-
-    static int SortHelper(const void* a, const void* b)
-    {
-        const ScheduledObject* soa = *(ScheduledObject**)a;
-        const ScheduledObject* sob = *(ScheduledObject**)b;
-
-        if (soa->z < sob->z) return -1;
-        if (soa->z > sob->z) return 1;
-        return 0;
-    }
-};
-
-struct ScheduledSidedef : public ScheduledObject
-{
-    GLArray array;
-    TexTexture* texture;
-    int id;
-    int start;
-    int len;
-
-    virtual void render(int pass)
-    {
-        if (!view3d->cullArray(array))
-            return;
-
-        if (pass == 1)
-        {
-            //glDepthMask(GL_FALSE);
-            //glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        }
-        else if (pass == 0) glDisable(GL_BLEND);
-
-        glEnable(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, texture->getTexture());
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-
-        // draw midtex
-        array.draw(GL_QUADS, start, len);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glDisable(GL_TEXTURE_2D);
-
-        if (pass == 1)
-        {
-            // restore texture wrapping parameters
-            //glDepthMask(GL_TRUE);
-        }
-        else if (pass == 0) glEnable(GL_BLEND);
-    }
-
-    virtual QVector4D getHighlight(int pass)
-    {
-        if (pass != 1) return QVector4D(0, 0, 0, 0);
-
-        if (view3d->hoverType == View3D::Hover_SidedefMiddle &&
-                view3d->hoverId == id) return color_hl;
-
-        return QVector4D(0, 0, 0, 0);
-    }
-};
-
-void View3D::render(int pass)
-{
-    // pass = 0 = render without fog and without textures; used for highlighting purposes.
-    // pass = 1 = render for display
-
-    // get matrix.
-    GLfloat rawmodelview[16];
-    glGetFloatv(GL_MODELVIEW_MATRIX, rawmodelview);
-    modelview = QMatrix4x4(rawmodelview);
-
-    GLfloat rawprojection[16];
-    glGetFloatv(GL_PROJECTION_MATRIX, rawprojection);
-    projection = QMatrix4x4(rawprojection);
-
-    QVector4D color_hl(0.5, 0.25, 0.0, 0.5);
-    QVector4D color_sel(0.5, 0.0, 0.0, 0.5);
-
-    glClearColor(0, 0, 0, 0);
-    glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
-
-    DoomMap* cmap = MainWindow::get()->getMap();
-    if (!cmap)
-        return;
-
-    QTime gt;
-    gt.start();
-
-    int rpass = 1;
-
-    int hlcolor = 0;
-    if (pass == 1)
-    {
-        rpass = 0;
-        highlightShader.bind();
-        highlightShader.setUniformValue("uFogSize", QVector2D(rdist-64, rdist));
-        hlcolor = highlightShader.uniformLocation("uHighlightColor");
-    }
-    else if (pass == 0)
-    {
-        midtexSelectShader.bind();
-    }
-
-    QVector<ScheduledObject*> scheduled;
-
-    int et_visibility = 0;
-    int et_gettexture = 0;
-    int et_glupdate = 0;
-    int et_cullarray = 0;
-    int et_drawplanes = 0;
-    int et_drawwalls = 0;
-    QTime et;
-    QTime et2;
-
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glEnable(GL_DEPTH_TEST);
-    // hueeeeeeeeeeeeeeeeeeeeeeeeee
-    glDisable(GL_BLEND);
-    glEnable(GL_TEXTURE_2D);
-
-    int ds = 0;
-    for (int i = 0; i < cmap->sectors.size(); i++)
-    {
-        DoomMapSector* sector = &cmap->sectors[i];
-        // dont render if too far
-        et.start();
-        if (!sector->isAnyWithin(posX, -posY, rdist+64))
-        {
-            et_visibility += et.elapsed();
-            continue;
-        }
-        et_visibility += et.elapsed();
-        ds++;
-
-        // find ceiling texture
-        // this NEVER returns null. at most - embedded resource that says "BROKEN TEXTURE"
-        et.start();
-        TexTexture* flatceiling = Tex_GetTexture(sector->textureceiling, TexTexture::Flat, true);
-        TexTexture* flatfloor = Tex_GetTexture(sector->texturefloor, TexTexture::Flat, true);
-        et_gettexture += et.elapsed();
-
-        // draw sector's floor and ceiling first
-        if (sector->glupdate)
-        {
-            et.start();
-            sector->glupdate = false;
-            sector->glfloor.vertices.clear();
-            sector->glceiling.vertices.clear();
-
-
-            for (int k = 0; k < 2; k++)
-            {
-                GLArray tri_floor = sector->triangles, tri_ceiling = sector->triangles;
-                for (int j = 0; j < sector->triangles.vertices.size(); j++)
-                {
-                    GLVertex& fv = tri_floor.vertices[j];
-                    GLVertex& cv = tri_ceiling.vertices[j];
-
-                    fv.z = sector->zatFloor(fv.x, fv.y);
-                    cv.z = sector->zatCeiling(cv.x, cv.y);
-
-                    if (k == 0)
-                    {
-                        fv.r = fv.g = fv.b = sector->lightlevel;
-                        fv.a = 255;
-
-                        cv.r = cv.g = cv.b = sector->lightlevel;
-                        cv.a = 255;
-                    }
-                    else if (k == 1)
-                    {
-                        VIEW3D_HELPER_PACKHOVERID(fv.r, fv.g, fv.b, fv.a, Hover_Floor, sector-cmap->sectors.data());
-                        VIEW3D_HELPER_PACKHOVERID(cv.r, cv.g, cv.b, cv.a, Hover_Ceiling, sector-cmap->sectors.data());
-                    }
-
-                    // set floor u/v
-                    fv.u = fv.x / flatfloor->getWidth();
-                    fv.v = fv.y / flatfloor->getHeight();
-
-                    // set ceiling u/v
-                    cv.u = cv.x / flatceiling->getWidth();
-                    cv.v = cv.y / flatceiling->getHeight();
-
-                    sector->glfloor.vertices.append(fv);
-                    sector->glceiling.vertices.append(cv);
-                }
-            }
-
-            sector->glfloor.update();
-            sector->glceiling.update();
-            et_glupdate += et.elapsed();
-        }
-
-        // draw lines around the sector.
-        for (int j = 0; j < sector->linedefs.size(); j++)
-        {
-            DoomMapLinedef* linedef = sector->linedefs[j];
-
-            DoomMapVertex* v1 = linedef->getV1(sector);
-            DoomMapVertex* v2 = linedef->getV2(sector);
-
-            DoomMapSidedef* sidedef = linedef->getSidedef(sector);
-            if (!sidedef)
-                continue; // wtf?
-
-            // for hovering
-            int sd_id = sidedef-cmap->sidedefs.data();
-
-            // now do different processing based on line type.
-            // single-sided line:
-            if (sidedef->glupdate)
-            {
-                et.start();
-                sidedef->glupdate = false;
-
-                GLVertex vv1, vv2, vv3, vv4;
-                vv1.x = v1->x;
-                vv1.y = -v1->y;
-                vv1.z = sector->zatCeiling(vv1.x, -vv1.y);
-
-                vv2.x = v2->x;
-                vv2.y = -v2->y;
-                vv2.z = sector->zatCeiling(vv2.x, -vv2.y);
-
-                vv3.x = v2->x;
-                vv3.y = -v2->y;
-                vv3.z = sector->zatFloor(vv3.x, -vv3.y);
-
-                vv4.x = v1->x;
-                vv4.y = -v1->y;
-                vv4.z = sector->zatFloor(vv4.x, -vv4.y);
-
-                quint8 c = 255;
-
-                QLineF line = QLineF(v1->x, v1->y, v2->x, v2->y);
-                float wvl = -16;
-                float whl = 16;
-                // scary formula taken from zdoom
-                float lite = whl
-                    + fabs(atan(double(line.dx()) / line.dy()) / 1.57079)
-                    * (wvl - whl);
-                lite += sector->lightlevel;
-                if (lite > 255) lite = 255;
-                if (lite < 0) lite = 0;
-
-                // set color
-                c = lite;
-
-                vv1.r=vv1.g=vv1.b=c;
-                vv2.r=vv2.g=vv2.b=c;
-                vv3.r=vv3.g=vv3.b=c;
-                vv4.r=vv4.g=vv4.b=c;
-
-                sidedef->gltop.vertices.clear();
-                sidedef->glbottom.vertices.clear();
-                sidedef->glmiddle.vertices.clear();
-                if (!linedef->getBack())
-                {
-                    et2.start();
-                    TexTexture* tex = Tex_GetTexture(sidedef->texturemiddle, TexTexture::Texture, true);
-                    et_gettexture += et2.elapsed();
-
-                    View3D_Helper_SetTextureOffsets(vv1, vv2, vv3, vv4, sector, 0, linedef, sidedef, line, tex, 2);
-
-                    sidedef->glmiddle.vertices.append(vv1);
-                    sidedef->glmiddle.vertices.append(vv2);
-                    sidedef->glmiddle.vertices.append(vv3);
-                    sidedef->glmiddle.vertices.append(vv4);
-
-                    VIEW3D_HELPER_PACKHOVERID(vv1.r, vv1.g, vv1.b, vv1.a, Hover_SidedefMiddle, sd_id);
-                    VIEW3D_HELPER_PACKHOVERID(vv2.r, vv2.g, vv2.b, vv2.a, Hover_SidedefMiddle, sd_id);
-                    VIEW3D_HELPER_PACKHOVERID(vv3.r, vv3.g, vv3.b, vv3.a, Hover_SidedefMiddle, sd_id);
-                    VIEW3D_HELPER_PACKHOVERID(vv4.r, vv4.g, vv4.b, vv4.a, Hover_SidedefMiddle, sd_id);
-
-                    sidedef->glmiddle.vertices.append(vv1);
-                    sidedef->glmiddle.vertices.append(vv2);
-                    sidedef->glmiddle.vertices.append(vv3);
-                    sidedef->glmiddle.vertices.append(vv4);
-                }
-                else
-                {
-                    // get the other sector
-                    DoomMapSector* other = (linedef->getFront()->getSector() == sector) ? linedef->getBack()->getSector() : linedef->getFront()->getSector();
-                    // make ourselves some more vertices for top and bottom linedef ending. also don't draw certain wall parts if other sector height is larger than current.
-                    // or draw. who the fuck cares.
-                    GLVertex ov1 = vv1, ov2 = vv2, ov3 = vv3, ov4 = vv4;
-                    ov1.z = std::min(sector->zatCeiling(ov1.x, -ov1.y), other->zatCeiling(ov1.x, -ov1.y));
-                    ov2.z = std::min(sector->zatCeiling(ov2.x, -ov2.y), other->zatCeiling(ov2.x, -ov2.y));
-                    ov3.z = std::max(sector->zatFloor(ov3.x, -ov3.y), other->zatFloor(ov3.x, -ov3.y));
-                    ov4.z = std::max(sector->zatFloor(ov4.x, -ov4.y), other->zatFloor(ov4.x, -ov4.y));
-
-                    // evaluate texture offsets
-                    et2.start();
-                    TexTexture* textop = Tex_GetTexture(sidedef->texturetop, TexTexture::Texture, true);
-                    TexTexture* texbottom = Tex_GetTexture(sidedef->texturebottom, TexTexture::Texture, true);
-                    TexTexture* texmiddle = (sidedef->texturemiddle != "-") ? Tex_GetTexture(sidedef->texturemiddle, TexTexture::Texture, true) : 0;
-                    et_gettexture += et2.elapsed();
-
-                    View3D_Helper_SetTextureOffsets(vv1, vv2, ov2, ov1, sector, other, linedef, sidedef, line, textop, 0);
-                    View3D_Helper_SetTextureOffsets(ov4, ov3, vv3, vv4, sector, other, linedef, sidedef, line, texbottom, 2);
-
-                    // top texture pass 1
-                    sidedef->gltop.vertices.append(vv1);
-                    sidedef->gltop.vertices.append(vv2);
-                    sidedef->gltop.vertices.append(ov2);
-                    sidedef->gltop.vertices.append(ov1);
-
-                    // bottom texture pass 1
-                    sidedef->glbottom.vertices.append(ov4);
-                    sidedef->glbottom.vertices.append(ov3);
-                    sidedef->glbottom.vertices.append(vv3);
-                    sidedef->glbottom.vertices.append(vv4);
-
-                    // middle texture pass 1
-                    if (texmiddle != 0)
-                    {
-                        View3D_Helper_SetTextureOffsets(ov1, ov2, ov3, ov4, sector, other, linedef, sidedef, line, texmiddle, 1);
-                        sidedef->glmiddle.vertices.append(ov1);
-                        sidedef->glmiddle.vertices.append(ov2);
-                        sidedef->glmiddle.vertices.append(ov3);
-                        sidedef->glmiddle.vertices.append(ov4);
-                    }
-
-                    // top texture pass 0
-                    VIEW3D_HELPER_PACKHOVERID(vv1.r, vv1.g, vv1.b, vv1.a, Hover_SidedefTop, sd_id);
-                    VIEW3D_HELPER_PACKHOVERID(vv2.r, vv2.g, vv2.b, vv2.a, Hover_SidedefTop, sd_id);
-                    VIEW3D_HELPER_PACKHOVERID(ov2.r, ov2.g, ov2.b, ov2.a, Hover_SidedefTop, sd_id);
-                    VIEW3D_HELPER_PACKHOVERID(ov1.r, ov1.g, ov1.b, ov1.a, Hover_SidedefTop, sd_id);
-
-                    sidedef->gltop.vertices.append(vv1);
-                    sidedef->gltop.vertices.append(vv2);
-                    sidedef->gltop.vertices.append(ov2);
-                    sidedef->gltop.vertices.append(ov1);
-
-                    // bottom texture pass 0
-                    VIEW3D_HELPER_PACKHOVERID(ov4.r, ov4.g, ov4.b, ov4.a, Hover_SidedefBottom, sd_id);
-                    VIEW3D_HELPER_PACKHOVERID(ov3.r, ov3.g, ov3.b, ov3.a, Hover_SidedefBottom, sd_id);
-                    VIEW3D_HELPER_PACKHOVERID(vv3.r, vv3.g, vv3.b, vv3.a, Hover_SidedefBottom, sd_id);
-                    VIEW3D_HELPER_PACKHOVERID(vv4.r, vv4.g, vv4.b, vv4.a, Hover_SidedefBottom, sd_id);
-
-                    sidedef->glbottom.vertices.append(ov4);
-                    sidedef->glbottom.vertices.append(ov3);
-                    sidedef->glbottom.vertices.append(vv3);
-                    sidedef->glbottom.vertices.append(vv4);
-
-                    // middle texture pass 0
-                    if (texmiddle != 0)
-                    {
-                        VIEW3D_HELPER_PACKHOVERID(ov1.r, ov1.g, ov1.b, ov1.a, Hover_SidedefMiddle, sd_id);
-                        VIEW3D_HELPER_PACKHOVERID(ov2.r, ov2.g, ov2.b, ov2.a, Hover_SidedefMiddle, sd_id);
-                        VIEW3D_HELPER_PACKHOVERID(ov3.r, ov3.g, ov3.b, ov3.a, Hover_SidedefMiddle, sd_id);
-                        VIEW3D_HELPER_PACKHOVERID(ov4.r, ov4.g, ov4.b, ov4.a, Hover_SidedefMiddle, sd_id);
-
-                        sidedef->glmiddle.vertices.append(ov1);
-                        sidedef->glmiddle.vertices.append(ov2);
-                        sidedef->glmiddle.vertices.append(ov3);
-                        sidedef->glmiddle.vertices.append(ov4);
-                    }
-                }
-
-                sidedef->gltop.update();
-                sidedef->glbottom.update();
-                sidedef->glmiddle.update();
-                et_glupdate += et.elapsed();
-            }
-
-            if (!linedef->getBack())
-            {
-                TexTexture* tex = Tex_GetTexture(sidedef->texturemiddle, TexTexture::Texture, true);
-
-                if (cullArray(sidedef->glmiddle))
-                {
-                    glBindTexture(GL_TEXTURE_2D, tex->getTexture());
-                    if (pass == 1) highlightShader.setUniformValue(hlcolor, (hoverType == Hover_SidedefMiddle && hoverId == sd_id) ? color_hl : QVector4D(0, 0, 0, 0));
-                    sidedef->glmiddle.draw(GL_QUADS, rpass*4, 4);
-                }
-            }
-            else
-            {
-                TexTexture* textop = Tex_GetTexture(sidedef->texturetop, TexTexture::Texture, true);
-                TexTexture* texbottom = Tex_GetTexture(sidedef->texturebottom, TexTexture::Texture, true);
-                TexTexture* texmiddle = (sidedef->texturemiddle != "-") ? Tex_GetTexture(sidedef->texturemiddle, TexTexture::Texture, true) : 0;
-
-                // top texture
-                et.start();
-                if (cullArray(sidedef->gltop))
-                {
-                    et_cullarray += et.elapsed();
-                    glBindTexture(GL_TEXTURE_2D, textop->getTexture());
-                    if (pass == 1) highlightShader.setUniformValue(hlcolor, (hoverType == Hover_SidedefTop && hoverId == sd_id) ? color_hl : QVector4D(0, 0, 0, 0));
-                    et.start();
-                    sidedef->gltop.draw(GL_QUADS, rpass*4, 4);
-                    et_drawwalls += et.elapsed();
-                }
-                else et_cullarray += et.elapsed();
-
-                // bottom texture
-                if (cullArray(sidedef->glbottom))
-                {
-                    et_cullarray += et.elapsed();
-                    glBindTexture(GL_TEXTURE_2D, texbottom->getTexture());
-                    if (pass == 1) highlightShader.setUniformValue(hlcolor, (hoverType == Hover_SidedefBottom && hoverId == sd_id) ? color_hl : QVector4D(0, 0, 0, 0));
-                    et.start();
-                    sidedef->glbottom.draw(GL_QUADS, rpass*4, 4);
-                    et_drawwalls += et.elapsed();
-                }
-                else et_cullarray += et.elapsed();
-
-                // schedule middle texture
-                if (texmiddle != 0)
-                {
-                    ScheduledSidedef* ssd = new ScheduledSidedef();
-                    ssd->view3d = this;
-                    ssd->color_hl = color_hl;
-                    ssd->color_sel = color_sel;
-                    ssd->id = sd_id;
-                    ssd->start = rpass*4;
-                    ssd->len = 4;
-
-                    ssd->array = sidedef->glmiddle;
-                    ssd->texture = texmiddle;
-
-                    // put z coord
-                    GLVertex center = ssd->array.getCenter();
-                    QVector3D centermult = QVector3D(center.x, center.y, center.z) * modelview;
-                    ssd->z = centermult.z();
-
-                    scheduled.append(ssd);
-                }
-            }
-        }
-
-        glBindTexture(GL_TEXTURE_2D, flatfloor->getTexture());
-
-        int sec_id = sector-cmap->sectors.data();
-        int tricnt = sector->triangles.vertices.size();
-
-        et.start();
-        if (cullArray(sector->glfloor))
-        {
-            et_cullarray += et.elapsed();
-            glFrontFace(GL_CCW);
-            if (pass == 1) highlightShader.setUniformValue(hlcolor, (hoverType == Hover_Floor && hoverId == sec_id) ? color_hl : QVector4D(0, 0, 0, 0));
-            et.start();
-            sector->glfloor.draw(GL_TRIANGLES, rpass*tricnt, tricnt);
-            et_drawplanes += et.elapsed();
-            glFrontFace(GL_CW);
-        }
-        else et_cullarray += et.elapsed();
-
-        et.start();
-        if (cullArray(sector->glceiling))
-        {
-            et_cullarray += et.elapsed();
-            glBindTexture(GL_TEXTURE_2D, flatceiling->getTexture());
-            if (pass == 1) highlightShader.setUniformValue(hlcolor, (hoverType == Hover_Ceiling && hoverId == sec_id) ? color_hl : QVector4D(0, 0, 0, 0));
-            et.start();
-            sector->glceiling.draw(GL_TRIANGLES, rpass*tricnt, tricnt);
-            et_drawplanes += et.elapsed();
-        }
-        else et_cullarray += et.elapsed();
-    }
-
-    glDisable(GL_TEXTURE_2D);
-    glEnable(GL_BLEND);
-
-    // draw scheduled middle textures
-    qsort(scheduled.data(), scheduled.size(), sizeof(ScheduledObject*), &ScheduledObject::SortHelper);
-    et.start();
-    for (int i = 0; i < scheduled.size(); i++)
-    {
-        ScheduledObject* o = scheduled[i];
-        if (pass == 1) highlightShader.setUniformValue(hlcolor, o->getHighlight(pass));
-        o->render(pass);
-        delete o;
-    }
-    et_drawwalls += et.elapsed();
-
-    /*    qint64 et_visibility = 0;
-    qint64 et_gettexture = 0;
-    qint64 et_glupdate = 0;
-    qint64 et_cullarray = 0;
-    qint64 et_drawplanes = 0;
-    qint64 et_drawwalls = 0;*/
-    //qDebug("et_visibility = %d; et_gettexture = %d; et_glupdate = %d; et_cullarray = %d; et_drawplanes = %d; et_drawwalls = %d;", et_visibility, et_gettexture, et_glupdate, et_cullarray, et_drawplanes, et_drawwalls);
-
-    scheduled.clear();
-
-    glDisable(GL_DEPTH_TEST);
-
-    if (pass == 1)
-    {
-        highlightShader.release();
-    }
-    else if (pass == 0)
-    {
-        midtexSelectShader.release();
-    }
-
-    if (pass == 1) // draw overlay
-    {
-        setClipRect(0, 0, width(), height());
-        renderOverlay();
-    }
-
-    //qDebug("pass = %d; time = %dms", pass, gt.elapsed());
-}
-
-void View3D::setClipRect(int x, int y, int w, int h)
-{
-    glViewport(x, height()-(y+h), w, h);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glOrtho(x, x+w, y+h, y, -65536, 65536); // I doubt it will ever draw 64k sprites at once
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-}
-
-void View3D::renderOverlay()
-{
-    // draw crosshair in the middle.
-    static TexTexture* tex_Xhair = 0;
-    if (!tex_Xhair) tex_Xhair = TexTexture::fromImage(QImage(":///resources/xhair.png"));
-
-    float cx = width()/2;
-    float cy = height()/2;
-    float sz = (float)tex_Xhair->getWidth() / 2;
-
-    GLArray xhaira;
-    xhaira.vertices.append(GLVertex(cx-sz, cy-sz, 0, 0, 0));
-    xhaira.vertices.append(GLVertex(cx+sz, cy-sz, 0, 1, 0));
-    xhaira.vertices.append(GLVertex(cx+sz, cy+sz, 0, 1, 1));
-    xhaira.vertices.append(GLVertex(cx-sz, cy+sz, 0, 0, 1));
-
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glEnable(GL_TEXTURE_2D);
-    glBindTexture(GL_TEXTURE_2D, tex_Xhair->getTexture());
-    xhaira.draw(GL_QUADS);
-    glDisable(GL_TEXTURE_2D);
-}
-
-bool View3D::cullArray(GLArray& a)
-{
-
-    for (int i = 0; i < a.vertices.size(); i++)
-    {
-        GLVertex& v = a.vertices[i];
-        QVector3D v3d(v.x, v.y, v.z);
-        v3d = v3d * modelview;
-        if (v3d.z() < 0)
-            return true;
-    }
-
-    return false;
-}
+#include "view3d.h"
+#include <QDebug>
+#include "mainwindow.h"
+#include "glarray.h"
+#include <cmath> // M_PI, tan()
+#include <QApplication>
+#include "data/texman.h"
+#include "data/maploadreport.h"
+#include <QTime>
+
+static const QGLFormat& GetView3DFormat()
+{
+    static QGLFormat fmt;
+    fmt = QGLFormat();
+    fmt.setVersion(2, 0);
+    fmt.setProfile(QGLFormat::CompatibilityProfile);
+    //fmt.setSampleBuffers(true);
+    return fmt;
+}
+
+// meshes of sidedefs and sectors that weren't drawn for this many frames are dropped
+static const int View3D_MeshMaxAge = 300;
+
+View3D::View3D(QWidget* parent) : QGLWidget(GetView3DFormat(), parent, MainWindow::get()->getSharedGLWidget()),
+                                  highlightShader(context(), this),
+                                  sidedefMeshes(3), sectorMeshes(2)
+{
+    setMouseTracking(true);
+    setFocusPolicy(Qt::StrongFocus);
+
+    repaintTimer = new QTimer(this);
+    connect(repaintTimer, SIGNAL(timeout()), this, SLOT(repaintTimerHandler()));
+    repaintTimer->setInterval(2); // ~30fps
+    repaintTimer->start();
+
+    wasVisible = false;
+    mouseXLast = mouseYLast = -1;
+
+    running = false;
+
+    hoverFBO = 0;
+
+    rdist = 1024;
+
+    thingsUpdate = false;
+
+    visitFrame = 0;
+    rangeFrame = 0;
+    actionTargetFrame = 0;
+}
+
+void View3D::initShader(QString name, QGLShaderProgram& out, QString filenamevx, QString filenamefr)
+{
+    if (!out.addShaderFromSourceFile(QGLShader::Vertex, filenamevx))
+    {
+        qDebug("View3D: failed to compile %s shader/vertex: %s", name.toUtf8().data(), highlightShader.log().toUtf8().data());
+        return;
+    }
+
+    if (!out.addShaderFromSourceFile(QGLShader::Fragment, filenamefr))
+    {
+        qDebug("View3D: failed to compile %s shader/fragment: %s", name.toUtf8().data(), highlightShader.log().toUtf8().data());
+        return;
+    }
+
+    if (!out.link())
+    {
+        qDebug("View3D: failed to link %s shader: %s", name.toUtf8().data(), highlightShader.log().toUtf8().data());
+        return;
+    }
+}
+
+void View3D::initializeGL()
+{
+    qDebug("initializing GL...");
+
+    // init entity highlight shader (basically mixes some highlight color with the texture)
+    initShader("highlight", highlightShader, ":/resources/highlightShader.vx", ":/resources/highlightShader.fr");
+
+    // init midtex select shader (stencil-like rendering only with alpha >0.5 of the actual midtex texture, used in offscreen rendering of masks)
+    initShader("midtex select", midtexSelectShader, ":/resources/midtexSelectShader.vx", ":/resources/midtexSelectShader.fr");
+
+    // init thing shader (billboards are expanded from texture coordinates, so the array doesn't depend on view angle)
+    initShader("thing", thingShader, ":/resources/thingShader.vx", ":/resources/thingShader.fr");
+
+    highlightShader.setUniformValue("uHighlightColor", QVector4D(0, 0, 0, 0));
+}
+
+void View3D::paintGL()
+{
+    // first render after map load goes to the load report. this is where gl arrays are built.
+    bool reportrender = MainWindow::get()->getMap() && MapLoadReport::get().isActive() && !MapLoadReport::get().hasPhase("first render");
+    MapLoadPhase* reportphase = reportrender ? new MapLoadPhase("first render") : 0;
+
+    setPerspective(140);
+
+    if (!hoverFBO || hoverFBO->width() != width() || hoverFBO->height() != height())
+    {
+        if (hoverFBO) delete hoverFBO;
+        hoverFBO = new QGLFramebufferObject(width(), height(), QGLFramebufferObject::Depth, GL_TEXTURE_2D);
+    }
+
+    sidedefMeshes.beginFrame(View3D_MeshMaxAge);
+    sectorMeshes.beginFrame(View3D_MeshMaxAge);
+
+    hoverFBO->bind();
+    render(0);
+    hoverFBO->release();
+    // slow operation. maybe do something about it later?
+    QImage fboImage(hoverFBO->toImage());
+    QImage image(fboImage.constBits(), fboImage.width(), fboImage.height(), QImage::Format_ARGB32);
+    QRgb colorCenter = image.pixel(image.width()/2, image.height()/2);
+    // unpack hovered surface.
+    hoverType = (HoverType)((colorCenter & 0x00FF0000) >> 16);
+    hoverId = ((colorCenter & 0xFFFF) << 8) | ((colorCenter & 0xFF000000) >> 24);
+    //qDebug("hoverType = %d; hoverId = %d", hoverType, hoverId);
+    if (MainWindow::get()->getMap())
+        updateActionTargets(MainWindow::get()->getMap());
+
+    render(1);
+
+    if (reportphase)
+    {
+        delete reportphase;
+        MainWindow::get()->setStatus(MapLoadReport::get().finish());
+    }
+}
+
+
+void View3D::resizeGL(int width, int height)
+{
+    //setClipRect(0, 0, width, height);
+    // this is done each frame anyway
+    update();
+}
+
+#include <QElapsedTimer>
+static QElapsedTimer qetfps;
+static int intfps = 0;
+void View3D::repaintTimerHandler()
+{
+    if (!qetfps.isValid())
+        qetfps.start();
+
+    intfps++;
+    if (qetfps.elapsed() > 1000)
+    {
+        qDebug("FPS: %d", intfps);
+        intfps = 0;
+        qetfps.restart();
+    }
+
+    // do something else? otherwise just remove this and connect to repaint()
+    //update();
+
+    if (isVisible() && !wasVisible)
+    {
+        //grabMouse();
+        //grabKeyboard();
+        becameVisible();
+        wasVisible = true;
+    }
+    else if (!isVisible() && wasVisible)
+    {
+        //releaseMouse();
+        //releaseKeyboard();
+        wasVisible = false;
+    }
+
+    if (!isVisible())
+        return;
+
+    updateMouseAngle();
+
+    // move the player
+    float dx = 0;
+    float dy = 0;
+    if (moveForward) dy += 1;
+    if (moveBackward) dy -= 1;
+    if (moveLeft) dx -= 1;
+    if (moveRight) dx += 1;
+
+    float movemul = 8;
+    if (running)
+        movemul *= 3;
+
+    QLineF vertvec(0, 0, 1, 0);
+    vertvec.setAngle(angX);
+    posZ -= dy*vertvec.dy()*movemul;
+    QLineF movevec(0, 0, dx, dy*vertvec.dx());
+    movevec.setAngle(movevec.angle()-angZ);
+    posX += movevec.dx()*movemul;
+    posY -= movevec.dy()*movemul;
+
+    //
+    repaint();
+}
+
+void View3D::initMap()
+{
+    DoomMap* cmap = MainWindow::get()->getMap();
+
+    //
+    posX = posY = posZ = 0;
+    posZ = 48;
+    angX = angY = angZ = 0;
+
+    mouseXLast = mouseYLast = -1;
+
+    moveForward = moveBackward = moveLeft = moveRight = 0;
+
+    thingsUpdate = true;
+
+    // component ids belong to the old map
+    sidedefMeshes.clear();
+    sectorMeshes.clear();
+}
+
+void View3D::updateMouseAngle()
+{
+    QPoint oldcpos = mapFromGlobal(QCursor::pos());
+
+    int deltaX = 0, deltaY = 0;
+
+    // check if center. ignore events that point to widget's center, as these are our own events.
+    QPoint center(width()/2, height()/2);
+
+    if (mouseXLast >= 0 && mouseYLast >= 0)
+    {
+        deltaX = center.x()-oldcpos.x();
+        deltaY = center.y()-oldcpos.y();
+
+        //if (deltaX) deltaX = (deltaX < 0) ? -1 : 1;
+        //if (deltaY) deltaY = (deltaY < 0) ? -1 : 1;
+
+        float mper1 = 0.25;
+        angX += (float)deltaY * mper1;
+        if (angX < -90) angX = -90;
+        else if (angX > 90) angX = 90;
+
+        angZ += (float)deltaX * mper1;
+        while (angZ < 0)
+            angZ += 360;
+        while (angZ > 360)
+            angZ -= 360;
+    }
+
+    mouseXLast = oldcpos.x();
+    mouseYLast = oldcpos.y();
+
+    QCursor c = cursor();
+    c.setPos(mapToGlobal(center));
+    c.setShape(Qt::BlankCursor);
+    setCursor(c);
+}
+
+void View3D::mousePressEvent(QMouseEvent* e)
+{
+
+}
+
+void View3D::mouseReleaseEvent(QMouseEvent* e)
+{
+
+}
+
+void View3D::wheelEvent(QWheelEvent* e)
+{
+
+}
+
+void View3D::keyPressEvent(QKeyEvent *e)
+{
+    if (e->isAutoRepeat())
+        return;
+
+    if (e->key() == Qt::Key_Return ||
+        e->key() == Qt::Key_Enter)
+    {
+        MainWindow::get()->set3DMode(false);
+    }
+    else if (e->key() == Qt::Key_W)
+    {
+        moveForward = true;
+    }
+    else if (e->key() == Qt::Key_A)
+    {
+        moveLeft = true;
+    }
+    else if (e->key() == Qt::Key_S)
+    {
+        moveBackward = true;
+    }
+    else if (e->key() == Qt::Key_D)
+    {
+        moveRight = true;
+    }
+    else if (e->key() == Qt::Key_Shift)
+    {
+        running = true;
+        //qDebug("running on");
+    }
+}
+
+void View3D::keyReleaseEvent(QKeyEvent *e)
+{
+    if (e->isAutoRepeat())
+        return;
+
+    if (e->key() == Qt::Key_W)
+    {
+        moveForward = false;
+    }
+    else if (e->key() == Qt::Key_A)
+    {
+        moveLeft = false;
+    }
+    else if (e->key() == Qt::Key_S)
+    {
+        moveBackward = false;
+    }
+    else if (e->key() == Qt::Key_D)
+    {
+        moveRight = false;
+    }
+    else if ((e->key() == Qt::Key_Shift) || (e->modifiers() & Qt::ShiftModifier))
+    {
+        running = false;
+        //qDebug("running off");
+    }
+}
+
+void View3D::becameVisible()
+{
+    // todo reset mouse
+    mouseXLast = mouseYLast = -1;
+    running = false;
+
+    // set x/y position to 2d mode position, and z position to eye level in the sector under the cursor
+    posX = MainWindow::get()->getMouseX();
+    posY = -MainWindow::get()->getMouseY();
+    posZ = 0;
+
+    DoomMap* cmap = MainWindow::get()->getMap();
+    int sector = cmap ? cmap->sectorAt(posX, -posY) : -1;
+    if (sector >= 0)
+        posZ = cmap->sectors[sector].zatFloor(posX, -posY) + 48;
+    //qDebug("posX = %f, posY = %f; posZ = %f", posX, posY, posZ);
+}
+
+void View3D::setPerspective(float fov)
+{
+    glViewport(0, 0, width(), height());
+
+    float aspect = (float)width() / height();
+    float fovy = fov/aspect;
+    float zNear = 1;
+    float zFar = rdist;
+
+    GLdouble xmin, xmax, ymin, ymax;
+
+    ymax = zNear * tan(fovy * M_PI / 360.0);
+    ymin = -ymax;
+    xmin = ymin * aspect;
+    xmax = ymax * aspect;
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+
+    glFrustum(xmin, xmax, ymin, ymax, zNear, zFar);
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    //
+    glRotatef(90-angX, 1, 0, 0);
+    glRotatef(angZ, 0, 0, 1);
+    glScalef(1, 1, -1);
+    glTranslatef(-posX, -posY, -posZ);
+}
+
+#define VIEW3D_HELPER_PACKHOVERID(a,b,c,d,hovertype,id) \
+    a = (int)(hovertype); \
+    b = ((id) & 0xFF0000) >> 16; \
+    c = ((id) & 0xFF00) >> 8; \
+    d = ((id) & 0xFF);
+
+// ewwwwwwwwwwwwwwwwwwwwwwwww this function is so ugly
+// it's used to compute similar, but different texture offsets for top/bottom/middle linedef parts.
+static void View3D_Helper_SetTextureOffsets(GLVertex& vv1, GLVertex& vv2, GLVertex& vv3, GLVertex& vv4, DoomMapSector* sector, DoomMapSector* other, DoomMapLinedef* linedef, DoomMapSidedef* sidedef, QLineF& line, TexTexture* tex, int part)
+{
+    bool top = (part == 0);
+    bool bottom = (part == 2);
+    bool middle = (part == 1);
+
+    float xbase = sidedef->offsetx;
+    float ybase = sidedef->offsety;
+    // lower unpegged means the texture should have origin at it's bottom, not top.
+    if (middle)
+    {
+        // if texture is lower unpegged, move it to bottom of own sidedef
+        if (linedef->dontpegbottom)
+        {
+            int ptd = (sector->heightceiling-sector->heightfloor) - tex->getHeight();
+            ybase -= ptd;
+        }
+    }
+    else if (linedef->dontpegbottom && !top)
+    {
+        int highestfloor = sector->heightfloor;
+        if (other) highestfloor = other->heightfloor;
+        int ptd = (sector->heightceiling-highestfloor) % tex->getHeight(); // 272 % 128
+        if (!other) ptd = -ptd;
+        ybase += ptd;
+    }
+    else if (!linedef->dontpegtop && top)
+    {
+        int ptd = tex->getHeight() - (sector->heightceiling - other->heightceiling);
+        ybase += ptd;
+    }
+    xbase /= tex->getWidth();
+    ybase /= tex->getHeight();
+    float xlen = line.length() / tex->getWidth();
+    float ylen1 = (vv1.z-vv4.z) / tex->getHeight();
+    float ylen2 = (vv2.z-vv3.z) / tex->getHeight();
+
+    vv1.u = xbase;
+    vv1.v = ybase;
+    vv2.u = xbase+xlen;
+    vv2.v = ybase;
+    vv3.u = xbase+xlen;
+    vv3.v = ybase+ylen2;
+    vv4.u = xbase;
+    vv4.v = ybase+ylen1;
+}
+
+// extracts 6 frustum planes (a*x+b*y+c*z+d >= 0 is inside) from current projection and modelview matrices.
+static void View3D_Helper_GetFrustum(float planes[6][4])
+{
+    GLfloat p[16];
+    GLfloat m[16];
+    glGetFloatv(GL_PROJECTION_MATRIX, p);
+    glGetFloatv(GL_MODELVIEW_MATRIX, m);
+
+    // clip = projection * modelview, column-major
+    float c[16];
+    for (int col = 0; col < 4; col++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            c[col*4+row] = p[0*4+row] * m[col*4+0] +
+                           p[1*4+row] * m[col*4+1] +
+                           p[2*4+row] * m[col*4+2] +
+                           p[3*4+row] * m[col*4+3];
+        }
+    }
+
+    // left, right, bottom, top, near, far
+    for (int i = 0; i < 6; i++)
+    {
+        int row = i / 2;
+        float sign = (i % 2) ? -1 : 1;
+        for (int j = 0; j < 4; j++)
+            planes[i][j] = c[j*4+3] + sign * c[j*4+row];
+    }
+}
+
+// bsp visitor that collects sectors in front to back order.
+class View3DSectorCollector : public DoomMapNodesVisitor
+{
+public:
+    DoomMap* map;
+    float (*frustum)[4];
+    float x;
+    float y;
+    float dist;
+
+    QVector<int>* order;
+    QVector<int>* visitFrame;
+    int frame;
+
+    int fromSector; // camera sector, for REJECT
+
+    virtual bool checkBox(const float* bbox, float zmin, float zmax)
+    {
+        // bbox is top, bottom, left, right in map coordinates.
+        float top = bbox[0];
+        float bottom = bbox[1];
+        float left = bbox[2];
+        float right = bbox[3];
+
+        // distance check
+        float dx = (x < left) ? (left - x) : ((x > right) ? (x - right) : 0);
+        float dy = (y < bottom) ? (bottom - y) : ((y > top) ? (y - top) : 0);
+        if (dx*dx + dy*dy > dist*dist)
+            return false;
+
+        if (zmin > zmax)
+            return true; // no heights known
+
+        // frustum check. world y is inverted map y.
+        float wxmin = left;
+        float wxmax = right;
+        float wymin = -top;
+        float wymax = -bottom;
+        for (int i = 0; i < 6; i++)
+        {
+            const float* pl = frustum[i];
+            float px = (pl[0] >= 0) ? wxmax : wxmin;
+            float py = (pl[1] >= 0) ? wymax : wymin;
+            float pz = (pl[2] >= 0) ? zmax : zmin;
+            if (pl[0]*px + pl[1]*py + pl[2]*pz + pl[3] < 0)
+                return false;
+        }
+
+        return true;
+    }
+
+    virtual void visitSubsector(int subsector)
+    {
+        int sector = map->nodes.subsectors[subsector].sector;
+        if (sector < 0 || (*visitFrame)[sector] == frame)
+            return;
+        (*visitFrame)[sector] = frame;
+        if (map->isRejected(fromSector, sector))
+            return;
+        order->append(sector);
+    }
+};
+
+void View3D::collectSectors(DoomMap* cmap)
+{
+    sectorOrder.clear();
+
+    if (!cmap->nodes.isValid())
+    {
+        // no nodes, just walk everything in index order
+        for (int i = 0; i < cmap->sectors.size(); i++)
+            sectorOrder.append(i);
+        return;
+    }
+
+    if (sectorVisitFrame.size() != cmap->sectors.size())
+    {
+        sectorVisitFrame.fill(-1, cmap->sectors.size());
+        visitFrame = 0;
+    }
+
+    visitFrame++;
+
+    float frustum[6][4];
+    View3D_Helper_GetFrustum(frustum);
+
+    View3DSectorCollector collector;
+    collector.map = cmap;
+    collector.frustum = frustum;
+    collector.x = posX;
+    collector.y = -posY;
+    collector.dist = rdist+64;
+    collector.order = &sectorOrder;
+    collector.visitFrame = &sectorVisitFrame;
+    collector.frame = visitFrame;
+
+    // sectors are rejected by REJECT as seen from the sector of the subsector the camera is in.
+    collector.fromSector = -1;
+    int camsubsector = cmap->nodes.subsectorAt(posX, -posY);
+    if (camsubsector >= 0)
+        collector.fromSector = cmap->nodes.subsectors[camsubsector].sector;
+
+    cmap->nodes.traverse(posX, -posY, &collector);
+}
+
+void View3D::markSectorsInRange(DoomMap* cmap)
+{
+    if (sectorRangeStamp.size() != cmap->sectors.size())
+    {
+        sectorRangeStamp.fill(-1, cmap->sectors.size());
+        rangeFrame = 0;
+    }
+
+    rangeFrame++;
+
+    // sectors with a vertex in range. the map's grid only gives sectors near the camera, instead of testing all of them.
+    QVector<int> inrange = cmap->getSectorsWithin(posX, -posY, rdist+64);
+    for (int i = 0; i < inrange.size(); i++)
+        sectorRangeStamp[inrange[i]] = rangeFrame;
+}
+
+void View3D::updateActionTargets(DoomMap* cmap)
+{
+    if (actionTargetStamp.size() != cmap->sectors.size())
+    {
+        actionTargetStamp.fill(-1, cmap->sectors.size());
+        actionTargetFrame = 0;
+    }
+
+    actionTargetFrame++;
+
+    if (hoverType != Hover_SidedefTop && hoverType != Hover_SidedefMiddle && hoverType != Hover_SidedefBottom)
+        return;
+
+    // this comes from the tag index, so it's as fast as the number of targets
+    QVector<int> targets = cmap->getLinedefTargetSectors(cmap->getSidedefLinedef(hoverId));
+    for (int i = 0; i < targets.size(); i++)
+        actionTargetStamp[targets[i]] = actionTargetFrame;
+}
+
+struct ScheduledObject
+{
+    View3D* view3d;
+    QVector4D color_hl;
+    QVector4D color_sel;
+    float z;
+
+    virtual void render(int pass) = 0;
+    virtual QVector4D getHighlight(int pass) = 0;
+
+    static int SortHelper(const void* a, const void* b)
+    {
+        const ScheduledObject* soa = *(ScheduledObject**)a;
+        const ScheduledObject* sob = *(ScheduledObject**)b;
+
+        if (soa->z < sob->z) return -1;
+        if (soa->z > sob->z) return 1;
+        return 0;
+    }
+};
+
+struct ScheduledSidedef : public ScheduledObject
+{
+    GLArray* array;
+    TexTexture* texture;
+    int id;
+    int start;
+    int len;
+
+    virtual void render(int pass)
+    {
+        if (!view3d->cullArray(*array))
+            return;
+
+        if (pass == 1)
+        {
+            //glDepthMask(GL_FALSE);
+            //glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        }
+        else if (pass == 0) glDisable(GL_BLEND);
+
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, texture->getTexture());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+
+        // draw midtex
+        array->draw(GL_QUADS, start, len);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glDisable(GL_TEXTURE_2D);
+
+        if (pass == 1)
+        {
+            // restore texture wrapping parameters
+            //glDepthMask(GL_TRUE);
+        }
+        else if (pass == 0) glEnable(GL_BLEND);
+    }
+
+    virtual QVector4D getHighlight(int pass)
+    {
+        if (pass != 1) return QVector4D(0, 0, 0, 0);
+
+        if (view3d->hoverType == View3D::Hover_SidedefMiddle &&
+                view3d->hoverId == id) return color_hl;
+
+        return QVector4D(0, 0, 0, 0);
+    }
+};
+
+void View3D::render(int pass)
+{
+    // pass = 0 = render without fog and without textures; used for highlighting purposes.
+    // pass = 1 = render for display
+
+    // get matrix.
+    GLfloat rawmodelview[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, rawmodelview);
+    modelview = QMatrix4x4(rawmodelview);
+
+    GLfloat rawprojection[16];
+    glGetFloatv(GL_PROJECTION_MATRIX, rawprojection);
+    projection = QMatrix4x4(rawprojection);
+
+    QVector4D color_hl(0.5, 0.25, 0.0, 0.5);
+    QVector4D color_sel(0.5, 0.0, 0.0, 0.5);
+    QVector4D color_target(0.0, 0.25, 0.5, 0.5);
+
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+
+    DoomMap* cmap = MainWindow::get()->getMap();
+    if (!cmap)
+        return;
+
+    // retriangulate sectors changed by edits since the last frame, and rebuild nodes once the edits settle
+    if (cmap->hasDirtySectors() || cmap->hasDirtyNodes())
+        cmap->updateDirtySectors();
+
+    QTime gt;
+    gt.start();
+
+    int rpass = 1;
+
+    int hlcolor = 0;
+    if (pass == 1)
+    {
+        rpass = 0;
+        highlightShader.bind();
+        highlightShader.setUniformValue("uFogSize", QVector2D(rdist-64, rdist));
+        hlcolor = highlightShader.uniformLocation("uHighlightColor");
+    }
+    else if (pass == 0)
+    {
+        midtexSelectShader.bind();
+    }
+
+    QVector<ScheduledObject*> scheduled;
+
+    int et_visibility = 0;
+    int et_gettexture = 0;
+    int et_glupdate = 0;
+    int et_cullarray = 0;
+    int et_drawplanes = 0;
+    int et_drawwalls = 0;
+    QTime et;
+    QTime et2;
+
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+    glEnable(GL_DEPTH_TEST);
+    // hueeeeeeeeeeeeeeeeeeeeeeeeee
+    glDisable(GL_BLEND);
+    glEnable(GL_TEXTURE_2D);
+
+    // walk sectors front to back using the bsp tree. whole subtrees outside of the view are rejected early, and near walls fill depth buffer first.
+    et.start();
+    collectSectors(cmap);
+    markSectorsInRange(cmap);
+    et_visibility += et.elapsed();
+
+    int ds = 0;
+    for (int i = 0; i < sectorOrder.size(); i++)
+    {
+        DoomMapSector* sector = &cmap->sectors[sectorOrder[i]];
+        // dont render if too far
+        if (!isSectorInRange(sectorOrder[i]))
+            continue;
+        ds++;
+
+        // find ceiling texture
+        // this NEVER returns null. at most - embedded resource that says "BROKEN TEXTURE"
+        et.start();
+        TexTexture* flatceiling = Tex_GetTextureById(sector->textureceiling, TexTexture::Flat, true);
+        TexTexture* flatfloor = Tex_GetTextureById(sector->texturefloor, TexTexture::Flat, true);
+        et_gettexture += et.elapsed();
+
+        // draw sector's floor and ceiling first
+        int sec_id = sectorOrder[i];
+        bool sectorbuilt = sectorMeshes.find(sec_id) != 0;
+        GLArray* glfloor = sectorMeshes.get(sec_id, 0);
+        GLArray* glceiling = sectorMeshes.get(sec_id, 1);
+        if (sector->glupdate || !sectorbuilt)
+        {
+            et.start();
+            sector->glupdate = false;
+            glfloor->vertices.clear();
+            glceiling->vertices.clear();
+
+
+            for (int k = 0; k < 2; k++)
+            {
+                for (int j = 0; j < sector->triangles.size(); j++)
+                {
+                    GLVertex fv = sector->triangles[j];
+                    GLVertex cv = sector->triangles[j];
+
+                    fv.z = sector->zatFloor(fv.x, fv.y);
+                    cv.z = sector->zatCeiling(cv.x, cv.y);
+
+                    if (k == 0)
+                    {
+                        fv.r = fv.g = fv.b = sector->lightlevel;
+                        fv.a = 255;
+
+                        cv.r = cv.g = cv.b = sector->lightlevel;
+                        cv.a = 255;
+                    }
+                    else if (k == 1)
+                    {
+                        VIEW3D_HELPER_PACKHOVERID(fv.r, fv.g, fv.b, fv.a, Hover_Floor, sector-cmap->sectors.data());
+                        VIEW3D_HELPER_PACKHOVERID(cv.r, cv.g, cv.b, cv.a, Hover_Ceiling, sector-cmap->sectors.data());
+                    }
+
+                    // set floor u/v
+                    fv.u = fv.x / flatfloor->getWidth();
+                    fv.v = fv.y / flatfloor->getHeight();
+
+                    // set ceiling u/v
+                    cv.u = cv.x / flatceiling->getWidth();
+                    cv.v = cv.y / flatceiling->getHeight();
+
+                    glfloor->vertices.append(fv);
+                    glceiling->vertices.append(cv);
+                }
+            }
+
+            glfloor->update();
+            glceiling->update();
+            et_glupdate += et.elapsed();
+        }
+
+        // draw lines around the sector.
+        int numlinedefs = sector->getLinedefCount(cmap);
+        for (int j = 0; j < numlinedefs; j++)
+        {
+            DoomMapLinedef* linedef = sector->getLinedef(cmap, j);
+
+            DoomMapVertex* v1 = linedef->getV1(cmap, sec_id);
+            DoomMapVertex* v2 = linedef->getV2(cmap, sec_id);
+
+            DoomMapSidedef* sidedef = linedef->getSidedef(cmap, sec_id);
+            if (!sidedef)
+                continue; // wtf?
+
+            // for hovering
+            int sd_id = sidedef-cmap->sidedefs.data();
+
+            bool sidedefbuilt = sidedefMeshes.find(sd_id) != 0;
+            GLArray* gltop = sidedefMeshes.get(sd_id, 0);
+            GLArray* glbottom = sidedefMeshes.get(sd_id, 1);
+            GLArray* glmiddle = sidedefMeshes.get(sd_id, 2);
+
+            // now do different processing based on line type.
+            // single-sided line:
+            if (sidedef->glupdate || !sidedefbuilt)
+            {
+                et.start();
+                sidedef->glupdate = false;
+
+                GLVertex vv1, vv2, vv3, vv4;
+                vv1.x = v1->x;
+                vv1.y = -v1->y;
+                vv1.z = sector->zatCeiling(vv1.x, -vv1.y);
+
+                vv2.x = v2->x;
+                vv2.y = -v2->y;
+                vv2.z = sector->zatCeiling(vv2.x, -vv2.y);
+
+                vv3.x = v2->x;
+                vv3.y = -v2->y;
+                vv3.z = sector->zatFloor(vv3.x, -vv3.y);
+
+                vv4.x = v1->x;
+                vv4.y = -v1->y;
+                vv4.z = sector->zatFloor(vv4.x, -vv4.y);
+
+                quint8 c = 255;
+
+                QLineF line = QLineF(v1->x, v1->y, v2->x, v2->y);
+                float wvl = -16;
+                float whl = 16;
+                // scary formula taken from zdoom
+                float lite = whl
+                    + fabs(atan(double(line.dx()) / line.dy()) / 1.57079)
+                    * (wvl - whl);
+                lite += sector->lightlevel;
+                if (lite > 255) lite = 255;
+                if (lite < 0) lite = 0;
+
+                // set color
+                c = lite;
+
+                vv1.r=vv1.g=vv1.b=c;
+                vv2.r=vv2.g=vv2.b=c;
+                vv3.r=vv3.g=vv3.b=c;
+                vv4.r=vv4.g=vv4.b=c;
+
+                gltop->vertices.clear();
+                glbottom->vertices.clear();
+                glmiddle->vertices.clear();
+                if (!linedef->getBack(cmap))
+                {
+                    et2.start();
+                    TexTexture* tex = Tex_GetTextureById(sidedef->texturemiddle, TexTexture::Texture, true);
+                    et_gettexture += et2.elapsed();
+
+                    View3D_Helper_SetTextureOffsets(vv1, vv2, vv3, vv4, sector, 0, linedef, sidedef, line, tex, 2);
+
+                    glmiddle->vertices.append(vv1);
+                    glmiddle->vertices.append(vv2);
+                    glmiddle->vertices.append(vv3);
+                    glmiddle->vertices.append(vv4);
+
+                    VIEW3D_HELPER_PACKHOVERID(vv1.r, vv1.g, vv1.b, vv1.a, Hover_SidedefMiddle, sd_id);
+                    VIEW3D_HELPER_PACKHOVERID(vv2.r, vv2.g, vv2.b, vv2.a, Hover_SidedefMiddle, sd_id);
+                    VIEW3D_HELPER_PACKHOVERID(vv3.r, vv3.g, vv3.b, vv3.a, Hover_SidedefMiddle, sd_id);
+                    VIEW3D_HELPER_PACKHOVERID(vv4.r, vv4.g, vv4.b, vv4.a, Hover_SidedefMiddle, sd_id);
+
+                    glmiddle->vertices.append(vv1);
+                    glmiddle->vertices.append(vv2);
+                    glmiddle->vertices.append(vv3);
+                    glmiddle->vertices.append(vv4);
+                }
+                else
+                {
+                    // get the other sector
+                    DoomMapSector* other = (linedef->getFront(cmap)->sector == sec_id) ? linedef->getBack(cmap)->getSector(cmap) : linedef->getFront(cmap)->getSector(cmap);
+                    // make ourselves some more vertices for top and bottom linedef ending. also don't draw certain wall parts if other sector height is larger than current.
+                    // or draw. who the fuck cares.
+                    GLVertex ov1 = vv1, ov2 = vv2, ov3 = vv3, ov4 = vv4;
+                    ov1.z = std::min(sector->zatCeiling(ov1.x, -ov1.y), other->zatCeiling(ov1.x, -ov1.y));
+                    ov2.z = std::min(sector->zatCeiling(ov2.x, -ov2.y), other->zatCeiling(ov2.x, -ov2.y));
+                    ov3.z = std::max(sector->zatFloor(ov3.x, -ov3.y), other->zatFloor(ov3.x, -ov3.y));
+                    ov4.z = std::max(sector->zatFloor(ov4.x, -ov4.y), other->zatFloor(ov4.x, -ov4.y));
+
+                    // evaluate texture offsets
+                    et2.start();
+                    TexTexture* textop = Tex_GetTextureById(sidedef->texturetop, TexTexture::Texture, true);
+                    TexTexture* texbottom = Tex_GetTextureById(sidedef->texturebottom, TexTexture::Texture, true);
+                    TexTexture* texmiddle = (sidedef->texturemiddle != Tex_NoTextureId) ? Tex_GetTextureById(sidedef->texturemiddle, TexTexture::Texture, true) : 0;
+                    et_gettexture += et2.elapsed();
+
+                    View3D_Helper_SetTextureOffsets(vv1, vv2, ov2, ov1, sector, other, linedef, sidedef, line, textop, 0);
+                    View3D_Helper_SetTextureOffsets(ov4, ov3, vv3, vv4, sector, other, linedef, sidedef, line, texbottom, 2);
+
+                    // top texture pass 1
+                    gltop->vertices.append(vv1);
+                    gltop->vertices.append(vv2);
+                    gltop->vertices.append(ov2);
+                    gltop->vertices.append(ov1);
+
+                    // bottom texture pass 1
+                    glbottom->vertices.append(ov4);
+                    glbottom->vertices.append(ov3);
+                    glbottom->vertices.append(vv3);
+                    glbottom->vertices.append(vv4);
+
+                    // middle texture pass 1
+                    if (texmiddle != 0)
+                    {
+                        View3D_Helper_SetTextureOffsets(ov1, ov2, ov3, ov4, sector, other, linedef, sidedef, line, texmiddle, 1);
+                        glmiddle->vertices.append(ov1);
+                        glmiddle->vertices.append(ov2);
+                        glmiddle->vertices.append(ov3);
+                        glmiddle->vertices.append(ov4);
+                    }
+
+                    // top texture pass 0
+                    VIEW3D_HELPER_PACKHOVERID(vv1.r, vv1.g, vv1.b, vv1.a, Hover_SidedefTop, sd_id);
+                    VIEW3D_HELPER_PACKHOVERID(vv2.r, vv2.g, vv2.b, vv2.a, Hover_SidedefTop, sd_id);
+                    VIEW3D_HELPER_PACKHOVERID(ov2.r, ov2.g, ov2.b, ov2.a, Hover_SidedefTop, sd_id);
+                    VIEW3D_HELPER_PACKHOVERID(ov1.r, ov1.g, ov1.b, ov1.a, Hover_SidedefTop, sd_id);
+
+                    gltop->vertices.append(vv1);
+                    gltop->vertices.append(vv2);
+                    gltop->vertices.append(ov2);
+                    gltop->vertices.append(ov1);
+
+                    // bottom texture pass 0
+                    VIEW3D_HELPER_PACKHOVERID(ov4.r, ov4.g, ov4.b, ov4.a, Hover_SidedefBottom, sd_id);
+                    VIEW3D_HELPER_PACKHOVERID(ov3.r, ov3.g, ov3.b, ov3.a, Hover_SidedefBottom, sd_id);
+                    VIEW3D_HELPER_PACKHOVERID(vv3.r, vv3.g, vv3.b, vv3.a, Hover_SidedefBottom, sd_id);
+                    VIEW3D_HELPER_PACKHOVERID(vv4.r, vv4.g, vv4.b, vv4.a, Hover_SidedefBottom, sd_id);
+
+                    glbottom->vertices.append(ov4);
+                    glbottom->vertices.append(ov3);
+                    glbottom->vertices.append(vv3);
+                    glbottom->vertices.append(vv4);
+
+                    // middle texture pass 0
+                    if (texmiddle != 0)
+                    {
+                        VIEW3D_HELPER_PACKHOVERID(ov1.r, ov1.g, ov1.b, ov1.a, Hover_SidedefMiddle, sd_id);
+                        VIEW3D_HELPER_PACKHOVERID(ov2.r, ov2.g, ov2.b, ov2.a, Hover_SidedefMiddle, sd_id);
+                        VIEW3D_HELPER_PACKHOVERID(ov3.r, ov3.g, ov3.b, ov3.a, Hover_SidedefMiddle, sd_id);
+                        VIEW3D_HELPER_PACKHOVERID(ov4.r, ov4.g, ov4.b, ov4.a, Hover_SidedefMiddle, sd_id);
+
+                        glmiddle->vertices.append(ov1);
+                        glmiddle->vertices.append(ov2);
+                        glmiddle->vertices.append(ov3);
+                        glmiddle->vertices.append(ov4);
+                    }
+                }
+
+                gltop->update();
+                glbottom->update();
+                glmiddle->update();
+                et_glupdate += et.elapsed();
+            }
+
+            if (!linedef->getBack(cmap))
+            {
+                TexTexture* tex = Tex_GetTextureById(sidedef->texturemiddle, TexTexture::Texture, true);
+
+                if (cullArray(*glmiddle))
+                {
+                    glBindTexture(GL_TEXTURE_2D, tex->getTexture());
+                    if (pass == 1) highlightShader.setUniformValue(hlcolor, (hoverType == Hover_SidedefMiddle && hoverId == sd_id) ? color_hl : QVector4D(0, 0, 0, 0));
+                    glmiddle->draw(GL_QUADS, rpass*4, 4);
+                }
+            }
+            else
+            {
+                TexTexture* textop = Tex_GetTextureById(sidedef->texturetop, TexTexture::Texture, true);
+                TexTexture* texbottom = Tex_GetTextureById(sidedef->texturebottom, TexTexture::Texture, true);
+                TexTexture* texmiddle = (sidedef->texturemiddle != Tex_NoTextureId) ? Tex_GetTextureById(sidedef->texturemiddle, TexTexture::Texture, true) : 0;
+
+                // top texture
+                et.start();
+                if (cullArray(*gltop))
+                {
+                    et_cullarray += et.elapsed();
+                    glBindTexture(GL_TEXTURE_2D, textop->getTexture());
+                    if (pass == 1) highlightShader.setUniformValue(hlcolor, (hoverType == Hover_SidedefTop && hoverId == sd_id) ? color_hl : QVector4D(0, 0, 0, 0));
+                    et.start();
+                    gltop->draw(GL_QUADS, rpass*4, 4);
+                    et_drawwalls += et.elapsed();
+                }
+                else et_cullarray += et.elapsed();
+
+                // bottom texture
+                if (cullArray(*glbottom))
+                {
+                    et_cullarray += et.elapsed();
+                    glBindTexture(GL_TEXTURE_2D, texbottom->getTexture());
+                    if (pass == 1) highlightShader.setUniformValue(hlcolor, (hoverType == Hover_SidedefBottom && hoverId == sd_id) ? color_hl : QVector4D(0, 0, 0, 0));
+                    et.start();
+                    glbottom->draw(GL_QUADS, rpass*4, 4);
+                    et_drawwalls += et.elapsed();
+                }
+                else et_cullarray += et.elapsed();
+
+                // schedule middle texture
+                if (texmiddle != 0)
+                {
+                    ScheduledSidedef* ssd = new ScheduledSidedef();
+                    ssd->view3d = this;
+                    ssd->color_hl = color_hl;
+                    ssd->color_sel = color_sel;
+                    ssd->id = sd_id;
+                    ssd->start = rpass*4;
+                    ssd->len = 4;
+
+                    ssd->array = glmiddle;
+                    ssd->texture = texmiddle;
+
+                    // put z coord
+                    GLVertex center = ssd->array->getCenter();
+                    QVector3D centermult = QVector3D(center.x, center.y, center.z) * modelview;
+                    ssd->z = centermult.z();
+
+                    scheduled.append(ssd);
+                }
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_2D, flatfloor->getTexture());
+
+        int tricnt = sector->triangles.size();
+
+        et.start();
+        if (cullArray(*glfloor))
+        {
+            et_cullarray += et.elapsed();
+            glFrontFace(GL_CCW);
+            if (pass == 1) highlightShader.setUniformValue(hlcolor, (hoverType == Hover_Floor && hoverId == sec_id) ? color_hl : isActionTarget(sec_id) ? color_target : QVector4D(0, 0, 0, 0));
+            et.start();
+            glfloor->draw(GL_TRIANGLES, rpass*tricnt, tricnt);
+            et_drawplanes += et.elapsed();
+            glFrontFace(GL_CW);
+        }
+        else et_cullarray += et.elapsed();
+
+        et.start();
+        if (cullArray(*glceiling))
+        {
+            et_cullarray += et.elapsed();
+            glBindTexture(GL_TEXTURE_2D, flatceiling->getTexture());
+            if (pass == 1) highlightShader.setUniformValue(hlcolor, (hoverType == Hover_Ceiling && hoverId == sec_id) ? color_hl : isActionTarget(sec_id) ? color_target : QVector4D(0, 0, 0, 0));
+            et.start();
+            glceiling->draw(GL_TRIANGLES, rpass*tricnt, tricnt);
+            et_drawplanes += et.elapsed();
+        }
+        else et_cullarray += et.elapsed();
+    }
+
+    glDisable(GL_TEXTURE_2D);
+
+    // things use their own shader, so rebind the pass shader afterwards
+    if (pass == 1) highlightShader.release();
+    else if (pass == 0) midtexSelectShader.release();
+    renderThings(pass);
+    if (pass == 1) highlightShader.bind();
+    else if (pass == 0) midtexSelectShader.bind();
+
+    glEnable(GL_BLEND);
+
+    // draw scheduled middle textures
+    qsort(scheduled.data(), scheduled.size(), sizeof(ScheduledObject*), &ScheduledObject::SortHelper);
+    et.start();
+    for (int i = 0; i < scheduled.size(); i++)
+    {
+        ScheduledObject* o = scheduled[i];
+        if (pass == 1) highlightShader.setUniformValue(hlcolor, o->getHighlight(pass));
+        o->render(pass);
+        delete o;
+    }
+    et_drawwalls += et.elapsed();
+
+    /*    qint64 et_visibility = 0;
+    qint64 et_gettexture = 0;
+    qint64 et_glupdate = 0;
+    qint64 et_cullarray = 0;
+    qint64 et_drawplanes = 0;
+    qint64 et_drawwalls = 0;*/
+    //qDebug("et_visibility = %d; et_gettexture = %d; et_glupdate = %d; et_cullarray = %d; et_drawplanes = %d; et_drawwalls = %d;", et_visibility, et_gettexture, et_glupdate, et_cullarray, et_drawplanes, et_drawwalls);
+
+    scheduled.clear();
+
+    glDisable(GL_DEPTH_TEST);
+
+    if (pass == 1)
+    {
+        highlightShader.release();
+    }
+    else if (pass == 0)
+    {
+        midtexSelectShader.release();
+    }
+
+    if (pass == 1) // draw overlay
+    {
+        setClipRect(0, 0, width(), height());
+        renderOverlay();
+    }
+
+    //qDebug("pass = %d; time = %dms", pass, gt.elapsed());
+}
+
+void View3D::setClipRect(int x, int y, int w, int h)
+{
+    glViewport(x, height()-(y+h), w, h);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(x, x+w, y+h, y, -65536, 65536); // I doubt it will ever draw 64k sprites at once
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+void View3D::renderOverlay()
+{
+    // draw crosshair in the middle.
+    static TexTexture* tex_Xhair = 0;
+    if (!tex_Xhair) tex_Xhair = TexTexture::fromImage(QImage(":///resources/xhair.png"));
+
+    float cx = width()/2;
+    float cy = height()/2;
+    float sz = (float)tex_Xhair->getWidth() / 2;
+
+    GLArray xhaira;
+    xhaira.vertices.append(GLVertex(cx-sz, cy-sz, 0, 0, 0));
+    xhaira.vertices.append(GLVertex(cx+sz, cy-sz, 0, 1, 0));
+    xhaira.vertices.append(GLVertex(cx+sz, cy+sz, 0, 1, 1));
+    xhaira.vertices.append(GLVertex(cx-sz, cy+sz, 0, 0, 1));
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, tex_Xhair->getTexture());
+    xhaira.draw(GL_QUADS);
+    glDisable(GL_TEXTURE_2D);
+}
+
+void View3D::renderThings(int pass)
+{
+    DoomMap* cmap = MainWindow::get()->getMap();
+    if (!cmap)
+        return;
+
+    DoomMapThings& things = cmap->things;
+
+    if (thingsUpdate)
+    {
+        thingsUpdate = false;
+        thingsArray.vertices.clear();
+        thingsArray.vertices.reserve(things.size()*8);
+
+        // things stand on the floor of their sector
+        QVector<QPointF> positions(things.size());
+        for (int i = 0; i < things.size(); i++)
+            positions[i] = QPointF(things.x[i], things.y[i]);
+        QVector<int> thingsectors = cmap->sectorsAt(positions);
+
+        for (int k = 0; k < 2; k++)
+        {
+            for (int i = 0; i < things.size(); i++)
+            {
+                float x = things.x[i];
+                float y = -things.y[i];
+                float z = things.z[i];
+                if (thingsectors[i] >= 0)
+                    z += cmap->sectors[thingsectors[i]].zatFloor(things.x[i], things.y[i]);
+
+                // billboard is as wide and tall as the thing's collision box
+                float hw, h;
+                DoomMapThings::getTypeSize(things.type[i], hw, h);
+
+                // u/v is the offset of the billboard corner from the thing position
+                GLVertex v[4];
+                v[0] = GLVertex(x, y, z, -hw, h);
+                v[1] = GLVertex(x, y, z, hw, h);
+                v[2] = GLVertex(x, y, z, hw, 0);
+                v[3] = GLVertex(x, y, z, -hw, 0);
+
+                for (int j = 0; j < 4; j++)
+                {
+                    if (k == 0)
+                    {
+                        // player starts are green, everything else is yellow.
+                        bool player = (things.type[i] >= 1 && things.type[i] <= 4);
+                        v[j].r = player ? 64 : 255;
+                        v[j].g = player ? 255 : 192;
+                        v[j].b = 64;
+                        v[j].a = 255;
+                    }
+                    else if (k == 1)
+                    {
+                        VIEW3D_HELPER_PACKHOVERID(v[j].r, v[j].g, v[j].b, v[j].a, Hover_Thing, i);
+                    }
+
+                    thingsArray.vertices.append(v[j]);
+                }
+            }
+        }
+
+        thingsArray.update();
+    }
+
+    int count = things.size();
+    if (!count)
+        return;
+
+    int rpass = (pass == 1) ? 0 : 1;
+
+    // camera right vector in world space is the first row of the modelview matrix
+    GLfloat rawmodelview[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, rawmodelview);
+
+    thingShader.bind();
+    thingShader.setUniformValue("uRight", QVector3D(rawmodelview[0], rawmodelview[4], rawmodelview[8]));
+    thingShader.setUniformValue("uFogSize", QVector2D(rdist-64, rdist));
+    thingShader.setUniformValue("uFog", (pass == 1) ? 1.0f : 0.0f);
+    thingShader.setUniformValue("uHighlightColor", QVector4D(0, 0, 0, 0));
+
+    glDisable(GL_CULL_FACE);
+    thingsArray.draw(GL_QUADS, rpass*count*4, count*4);
+
+    // draw hovered thing over itself with highlight
+    if (pass == 1 && hoverType == Hover_Thing && hoverId >= 0 && hoverId < count)
+    {
+        glDepthFunc(GL_LEQUAL);
+        thingShader.setUniformValue("uHighlightColor", QVector4D(0.5, 0.25, 0.0, 0.5));
+        thingsArray.draw(GL_QUADS, hoverId*4, 4);
+        glDepthFunc(GL_LESS);
+    }
+
+    glEnable(GL_CULL_FACE);
+    thingShader.release();
+}
+
+bool View3D::cullArray(GLArray& a)
+{
+
+    for (int i = 0; i < a.vertices.size(); i++)
+    {
+        GLVertex& v = a.vertices[i];
+        QVector3D v3d(v.x, v.y, v.z);
+        v3d = v3d * modelview;
+        if (v3d.z() < 0)
+            return true;
+    }
+
+    return false;
+}